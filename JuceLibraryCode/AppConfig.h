@@ -19,6 +19,16 @@
 
 // (You can add your own code in this section, and the Introjucer will not overwrite it)
 
+// Set to 1 to log the analysis/playback benchmarks while loading a file
+#ifndef SHIFTY_RUN_BENCHMARKS
+ #define SHIFTY_RUN_BENCHMARKS 0
+#endif
+
+// Set to 1 to play bass, texture and drum layers on top of the main shifty looping walk
+#ifndef SHIFTY_LAYERED_LOOPING
+ #define SHIFTY_LAYERED_LOOPING 0
+#endif
+
 // [END_USER_CODE_SECTION]
 
 //==============================================================================
@@ -0,0 +1,192 @@
+/*
+  ==============================================================================
+
+    AliasTable.cpp
+    Created: 18 Oct 2026 10:02:19am
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "AliasTable.h"
+
+namespace mkov{
+
+static const float minTemperature = 0.05f, maxTemperature = 20.0f;
+
+AliasTable::AliasTable(const TransitionGraph& g) : graph(g), exponent(1.0f), epoch(0)
+{
+    build();
+}
+
+AliasTable::~AliasTable(){}
+
+void AliasTable::build(){
+    threshold.assign(static_cast<size_t>(graph.getNumEdges()), 1.0f);
+    alias.assign(static_cast<size_t>(graph.getNumEdges()), 0);
+    deadRow.assign(static_cast<size_t>(graph.getNumStates()), 0);
+    rowMax.assign(static_cast<size_t>(graph.getNumStates()), 0.0f);
+    rowEpoch.assign(static_cast<size_t>(graph.getNumStates()), 0);
+
+    for (int i = 0; i < graph.getNumStates(); ++i)
+        buildRow(i);
+}
+
+void AliasTable::setTemperature(float newTemperature) noexcept {
+    exponent.set(1.0f / jlimit(minTemperature, maxTemperature, newTemperature));
+    //after the exponent, so a row rebuilt in between is only rebuilt again
+    ++epoch;
+}
+
+void AliasTable::buildRow(int state){
+    const int begin  = graph.getRowBegin(state);
+    const int degree = graph.getDegree(state);
+    if (degree == 0) return;
+
+    const float* weights = graph.getWeights() + begin;
+    float largest = 0.0f;
+    for (int n = 0; n < degree; ++n)
+        largest = jmax(largest, weights[n]);
+    rowMax[state] = largest;
+
+    buildTemperedRow(state, epoch.get());
+}
+
+int AliasTable::restart(int state, float slot) const noexcept {
+    //a few removed loops cost a few probes; only if all are gone does the walk stay put
+    const int numStates = graph.getNumStates();
+    const int first = jmin(numStates - 1, static_cast<int>(slot * numStates));
+    for (int n = 0; n < numStates; ++n){
+        const int candidate = (first + n) % numStates;
+        if (!graph.isRemoved(candidate))
+            return candidate;
+    }
+    return state;
+}
+
+void AliasTable::buildTemperedRow(int state, int forEpoch){
+    const int begin  = graph.getRowBegin(state);
+    const int degree = graph.getDegree(state);
+    rowEpoch[state] = forEpoch;
+
+    //w^(1/T) scaled by max^(-1/T), which the normalisation below cancels anyway
+    const float* raw = graph.getWeights() + begin;
+    const float x = exponent.get();
+    const float scale = rowMax[state] > 0.0f ? 1.0f / rowMax[state] : 0.0f;
+    tempered.resize(static_cast<size_t>(degree));
+    for (int n = 0; n < degree; ++n)
+        tempered[n] = x == 1.0f ? raw[n] * scale : std::pow(raw[n] * scale, x);
+    const float* weights = tempered.data();
+
+    float* p = threshold.data() + begin;
+    int*   a = alias.data() + begin;
+
+    //Vose: scale so the average slot holds 1, then let each under-full slot
+    //borrow the rest of its probability from an over-full one
+    float rowSum = 0.0f;
+    for (int n = 0; n < degree; ++n)
+        rowSum += weights[n];
+
+    deadRow[state] = rowSum > 0.0f ? 0 : 1;
+    if (deadRow[state]) return;
+
+    small.clear();
+    large.clear();
+    for (int n = 0; n < degree; ++n){
+        p[n] = weights[n] * degree / rowSum;
+        a[n] = n;
+        (p[n] < 1.0f ? small : large).push_back(n);
+    }
+
+    while (!small.empty() && !large.empty()){
+        const int s = small.back(); small.pop_back();
+        const int l = large.back();
+        a[s] = l;
+        p[l] -= 1.0f - p[s];
+        if (p[l] < 1.0f){
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    //whatever is left over is full up to rounding error
+    for (int n : small) p[n] = 1.0f;
+    for (int n : large) p[n] = 1.0f;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class AliasTableTests : public UnitTest {
+public:
+    AliasTableTests() : UnitTest("AliasTable") {}
+
+    void runTest() override {
+        beginTest("Dead rows restart the walk");
+        {
+            TransitionGraph graph;
+            buildTwoRings(graph);
+            AliasTable table(graph);
+            remove(graph, table, 1);
+            remove(graph, table, 2);
+
+            //0 only leads to 1 and 2, and 3 and 4 only lead back to 0 or each other
+            Random random(1);
+            Array<int> visited;
+            int removedVisits = 0;
+            for (int n = 0, state = 0; n < 1000; ++n){
+                state = table.sample(state, random.nextFloat(), random.nextFloat());
+                removedVisits += graph.isRemoved(state) ? 1 : 0;
+                visited.addIfNotAlreadyThere(state);
+            }
+            expectEquals(removedVisits, 0);
+            expect(visited.size() > 3, "the walk got stuck");
+        }
+
+        beginTest("A removed neighbourhood is left for a live one");
+        {
+            TransitionGraph graph;
+            buildTwoRings(graph);
+            AliasTable table(graph);
+            for (int state = 0; state < ringSize; ++state)
+                remove(graph, table, state);
+
+            //starting inside the removed ring, every step lands in the other one
+            Random random(2);
+            int outside = 0;
+            for (int n = 0, state = 0; n < 1000; ++n){
+                state = table.sample(state, random.nextFloat(), random.nextFloat());
+                outside += state >= ringSize ? 1 : 0;
+            }
+            expectEquals(outside, 1000);
+        }
+    }
+
+private:
+    enum { ringSize = 5 };
+
+    //two rings of ringSize states, each state leading to the next two in its ring
+    static void buildTwoRings(TransitionGraph& graph){
+        std::vector<std::vector<TransitionGraph::Neighbour> > rows(2 * ringSize);
+        for (int i = 0; i < 2 * ringSize; ++i){
+            const int ring = i - i % ringSize;
+            for (int step = 1; step <= 2; ++step){
+                const TransitionGraph::Neighbour n = { static_cast<float>(step), ring + (i + step) % ringSize };
+                rows[i].push_back(n);
+            }
+        }
+        graph.assign(rows, 2);
+    }
+
+    static void remove(TransitionGraph& graph, AliasTable& table, int state){
+        Array<int> changedRows;
+        graph.removeState(state, changedRows);
+        for (int row : changedRows)
+            table.buildRow(row);
+    }
+};
+
+static AliasTableTests aliasTableTests;
+
+#endif
+
+}
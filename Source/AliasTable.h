@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    AliasTable.h
+    Created: 18 Oct 2026 10:02:19am
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef ALIASTABLE_H_INCLUDED
+#define ALIASTABLE_H_INCLUDED
+
+#include <vector>
+#include "JuceHeader.h"
+#include "TransitionGraph.h"
+
+namespace mkov{
+
+/*
+    Walker/Vose alias tables for every row of a TransitionGraph, laid out
+    alongside the graph's CSR edges. Drawing a successor then costs one random
+    edge of the row and one biased coin, whatever the row's degree. Shared by
+    any number of MarkovWalkers. Sampling may rebuild a row, so, like changing
+    the graph and rebuilding rows, it must happen under getLock() unless
+    nobody else can see the table.
+
+    A temperature T reshapes every row to p ~ w^(1/T) without touching the
+    graph: low T keeps to the most similar loops, high T wanders. Setting it
+    only bumps an epoch; each row is rebuilt the next time it is sampled,
+    from its cached maximum weight, so the cost is spread over the walk.
+*/
+class AliasTable {
+public:
+    explicit AliasTable(const TransitionGraph& graph);
+    ~AliasTable();
+
+    /** Rebuilds every row, e.g. after the graph has been rebuilt. */
+    void build();
+    /** Rebuilds one row in O(degree) after its weights changed. */
+    void buildRow(int state);
+
+    /** O(1) and lock free, so it can follow a slider. Clamped to a usable range. */
+    void  setTemperature(float newTemperature) noexcept;
+    float getTemperature() const noexcept { return 1.0f / exponent.get(); }
+
+    const TransitionGraph& getGraph() const noexcept { return graph; }
+    const CriticalSection& getLock() const noexcept  { return lock; }
+
+    /** The successor picked by a uniform slot in [0, 1) and a coin in [0, 1).
+        A dead end (no live successors) restarts the walk from the first live
+        state at or after slot. Rebuilds the row first if the temperature
+        changed since it was last sampled. */
+    int sample(int state, float slot, float coin) noexcept {
+        const int begin = graph.getRowBegin(state);
+        const int degree = graph.getRowEnd(state) - begin;
+        if (degree == 0)
+            return restart(state, slot);
+
+        const int current = epoch.get();
+        if (rowEpoch[state] != current)
+            buildTemperedRow(state, current);
+        if (deadRow[state])
+            return restart(state, slot);
+
+        const int e = begin + jmin(degree - 1, static_cast<int>(slot * degree));
+        return graph.getColumns()[coin < threshold[e] ? e : begin + alias[e]];
+    }
+
+private:
+    const TransitionGraph& graph;
+    std::vector<float> threshold;   //chance of keeping edge e rather than its alias
+    std::vector<int>   alias;       //the other edge in e's slot, relative to the row start
+    std::vector<char>  deadRow;     //every successor removed; the walk restarts
+    std::vector<float> rowMax;      //largest weight in the row, so w/max never underflows
+    std::vector<int>   rowEpoch;    //the temperature each row was last built for
+    std::vector<int>   small, large;    //scratch for buildTemperedRow(), guarded by lock
+    std::vector<float> tempered;
+    Atomic<float> exponent;         //1 / T
+    Atomic<int>   epoch;
+    CriticalSection lock;
+
+    void buildTemperedRow(int state, int forEpoch);
+    int  restart(int state, float slot) const noexcept;
+
+    AliasTable(const AliasTable&);
+    AliasTable& operator=(const AliasTable&);
+};
+
+}
+
+#endif  // ALIASTABLE_H_INCLUDED
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    AllocationCounter.cpp
+    Created: 17 Oct 2026 11:02:15am
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+#if JUCE_WINDOWS
+ #include <malloc.h>
+#endif
+
+#if SHIFTY_COUNT_ALLOCATIONS
+
+//per thread: a plain integer, so counting needs neither atomics nor the heap
+static thread_local int64 allocationCount = 0;
+
+static void* countedAlloc(std::size_t size) noexcept {
+    ++allocationCount;
+    return std::malloc(size != 0 ? size : 1);
+}
+
+static void* countedAllocOrThrow(std::size_t size){
+    if (void* p = countedAlloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+//every replaceable form, so nothing reaches the heap past the count
+void* operator new(std::size_t size)                                     { return countedAllocOrThrow(size); }
+void* operator new[](std::size_t size)                                   { return countedAllocOrThrow(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept     { return countedAlloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept   { return countedAlloc(size); }
+void  operator delete(void* p) noexcept                                  { std::free(p); }
+void  operator delete[](void* p) noexcept                                { std::free(p); }
+void  operator delete(void* p, const std::nothrow_t&) noexcept           { std::free(p); }
+void  operator delete[](void* p, const std::nothrow_t&) noexcept         { std::free(p); }
+
+ #if __cpp_sized_deallocation
+void  operator delete(void* p, std::size_t) noexcept                     { std::free(p); }
+void  operator delete[](void* p, std::size_t) noexcept                   { std::free(p); }
+ #endif
+
+ #if __cpp_aligned_new
+static void* countedAlignedAlloc(std::size_t size, std::align_val_t alignment) noexcept {
+    ++allocationCount;
+    size = size != 0 ? size : 1;
+   #if JUCE_WINDOWS
+    return _aligned_malloc(size, static_cast<std::size_t>(alignment));
+   #else
+    void* p = nullptr;
+    return posix_memalign(&p, jmax(sizeof(void*), static_cast<std::size_t>(alignment)), size) == 0 ? p : nullptr;
+   #endif
+}
+
+static void* countedAlignedAllocOrThrow(std::size_t size, std::align_val_t alignment){
+    if (void* p = countedAlignedAlloc(size, alignment))
+        return p;
+    throw std::bad_alloc();
+}
+
+static void alignedFree(void* p) noexcept {
+   #if JUCE_WINDOWS
+    _aligned_free(p);
+   #else
+    std::free(p);
+   #endif
+}
+
+void* operator new(std::size_t size, std::align_val_t a)                                     { return countedAlignedAllocOrThrow(size, a); }
+void* operator new[](std::size_t size, std::align_val_t a)                                   { return countedAlignedAllocOrThrow(size, a); }
+void* operator new(std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept     { return countedAlignedAlloc(size, a); }
+void* operator new[](std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept   { return countedAlignedAlloc(size, a); }
+void  operator delete(void* p, std::align_val_t) noexcept                                    { alignedFree(p); }
+void  operator delete[](void* p, std::align_val_t) noexcept                                  { alignedFree(p); }
+void  operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept             { alignedFree(p); }
+void  operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept           { alignedFree(p); }
+void  operator delete(void* p, std::size_t, std::align_val_t) noexcept                       { alignedFree(p); }
+void  operator delete[](void* p, std::size_t, std::align_val_t) noexcept                     { alignedFree(p); }
+ #endif
+
+#endif
+
+namespace lgen{
+
+int64 AllocationCounter::getTotal() noexcept {
+   #if SHIFTY_COUNT_ALLOCATIONS
+    return allocationCount;
+   #else
+    return 0;
+   #endif
+}
+
+}
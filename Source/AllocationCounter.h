@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    AllocationCounter.h
+    Created: 17 Oct 2026 11:02:15am
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef ALLOCATIONCOUNTER_H_INCLUDED
+#define ALLOCATIONCOUNTER_H_INCLUDED
+
+#include "JuceHeader.h"
+
+//Replaces the global operator new in debug builds so hot paths can be checked for
+//heap traffic. Define it to 0 (or 1) in the project settings to override.
+#ifndef SHIFTY_COUNT_ALLOCATIONS
+ #define SHIFTY_COUNT_ALLOCATIONS JUCE_DEBUG
+#endif
+
+namespace lgen{
+
+/*
+    Counts heap allocations made by the calling thread since it was constructed,
+    so other threads (e.g. the rest of a ThreadPool) never show up in the count.
+    Read it on the thread that created it. Always reads 0 when
+    SHIFTY_COUNT_ALLOCATIONS is off.
+*/
+class AllocationCounter {
+public:
+    AllocationCounter() noexcept : start(getTotal()) {}
+
+    int64 getCount() const noexcept { return getTotal() - start; }
+
+    /** Allocations made so far by the calling thread. */
+    static int64 getTotal() noexcept;
+
+private:
+    const int64 start;
+};
+
+}
+
+#endif  // ALLOCATIONCOUNTER_H_INCLUDED
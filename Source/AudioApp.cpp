@@ -248,6 +248,23 @@ AudioApp::AudioApp ()
     delayLabel->setColour (TextEditor::backgroundColourId, Colour (0x00000000));
     delayLabel->setColour (TextEditor::highlightColourId, Colours::red);
 
+    addAndMakeVisible (shiftinessSlider = new Slider ("Shiftiness"));
+    shiftinessSlider->setRange (0.1, 4, 0);
+    shiftinessSlider->setSliderStyle (Slider::LinearHorizontal);
+    shiftinessSlider->setTextBoxStyle (Slider::NoTextBox, true, 80, 20);
+    shiftinessSlider->setColour (Slider::backgroundColourId, Colour (0x00450707));
+    shiftinessSlider->addListener (this);
+    shiftinessSlider->setSkewFactor (0.5);
+
+    addAndMakeVisible (shiftinessLabel = new Label ("Shiftiness Label",
+                                                    TRANS("Shiftiness")));
+    shiftinessLabel->setFont (Font ("Arial Black", 15.00f, Font::plain));
+    shiftinessLabel->setJustificationType (Justification::centredLeft);
+    shiftinessLabel->setEditable (false, false, false);
+    shiftinessLabel->setColour (Label::textColourId, Colours::azure);
+    shiftinessLabel->setColour (TextEditor::textColourId, Colours::black);
+    shiftinessLabel->setColour (TextEditor::backgroundColourId, Colour (0x00000000));
+
 
     //[UserPreSize]
     backgroundImage = new ImageComponent();
@@ -275,6 +292,7 @@ AudioApp::AudioApp ()
     pitchSlider->setEnabled(false);
     tempoSlider->setEnabled(false);
     rateSlider->setEnabled(false);
+    shiftinessSlider->setValue(1.0, dontSendNotification);
     recordingButton->setEnabled(false);
 
     //Audio device setup
@@ -337,16 +355,23 @@ AudioApp::~AudioApp()
     reverbButton = nullptr;
     delaySlider = nullptr;
     delayLabel = nullptr;
+    shiftinessSlider = nullptr;
+    shiftinessLabel = nullptr;
 
 
     //[Destructor]. You can add your own custom destruction code here..
     stopTimer();
+    shiftyLooper.clearLayers();
+    loopLayers.clear();
+    shiftyLooper.setGenerator(nullptr, 0);
+    shiftyLooper.setSplicePlanner(nullptr);
+    splicePlanner = nullptr;
+    markovGenerator = nullptr;
+    markovModel = nullptr;
     //if (tableEnabled) loopTable = nullptr;
     //loopTable = nullptr;
 
     backgroundImage = nullptr;
-    similarity = nullptr;
-    transMat = nullptr;
     masterLogger = nullptr;
     currentLoop = nullptr;
     shiftyLooper.removeListener(this);
@@ -402,6 +427,8 @@ void AudioApp::resized()
     reverbButton->setBounds (104, 320, 24, 24);
     delaySlider->setBounds (56, 440, 208, 24);
     delayLabel->setBounds (120, 400, 72, 24);
+    shiftinessSlider->setBounds (448, 472, 168, 24);
+    shiftinessLabel->setBounds (352, 472, 96, 24);
     //[UserResized] Add your own custom resize handling here..
     backgroundImage->setBounds(0,0,getWidth(), getHeight());
     //[/UserResized]
@@ -500,7 +527,8 @@ void AudioApp::sliderValueChanged (Slider* sliderThatWasMoved)
     {
         //[UserSliderCode_gainSlider] -- add your slider handling code here..
         gain = static_cast<float>(gainSlider->getValue());
-        sourcePlayer.setGain(gain);
+        shiftyLooper.getEffectParameters().setGain(gain);
+        sourcePlayer.setGain(state == ShiftyLooping ? 1.0f : gain);
         //[/UserSliderCode_gainSlider]
     }
     else if (sliderThatWasMoved == rateSlider)
@@ -537,6 +565,8 @@ void AudioApp::sliderValueChanged (Slider* sliderThatWasMoved)
         //[UserSliderCode_reverbSlider] -- add your slider handling code here..
         rv_params.wetLevel = reverbSlider->getValue();
         verb.setParameters(rv_params);
+        shiftyLooper.getEffectParameters().setReverbWet(static_cast<float>((reverbSlider->getValue() - reverbSlider->getMinimum())
+                                                                            / (reverbSlider->getMaximum() - reverbSlider->getMinimum())));
        // reverbButton->setToggleState(false, sendNotification);
        // reverbButton->setToggleState(true, sendNotification);
         //[/UserSliderCode_reverbSlider]
@@ -546,6 +576,17 @@ void AudioApp::sliderValueChanged (Slider* sliderThatWasMoved)
         //[UserSliderCode_delaySlider] -- add your slider handling code here..
         //[/UserSliderCode_delaySlider]
     }
+    else if (sliderThatWasMoved == shiftinessSlider)
+    {
+        //[UserSliderCode_shiftinessSlider] -- add your slider handling code here..
+        //only bumps the table's epoch; rows are re-tempered as the walk reaches them
+        if (markovModel != nullptr){
+            markovModel->setShiftiness(static_cast<float>(shiftinessSlider->getValue()));
+            if (markovGenerator != nullptr)
+                markovGenerator->discardQueued();
+        }
+        //[/UserSliderCode_shiftinessSlider]
+    }
 
     //[UsersliderValueChanged_Post]
     //[/UsersliderValueChanged_Post]
@@ -566,8 +607,15 @@ void AudioApp::loadFile(){
 }
 //==============================================================================
 void AudioApp::initialize(){
-    shiftyLooper.setFile(*auxFile);
-    waveform->setFile(*auxFile);
+    //mapped (WAV) or decoded once; the player, the waveform and the analysis all share it
+    audioAsset = lgen::AudioAsset::createFromFile(*auxFile);
+    if (audioAsset == nullptr){
+        AlertWindow::showMessageBoxAsync(AlertWindow::WarningIcon, "Audio File", "Unable to decode audiofile");
+        return;
+    }
+    shiftyLooper.setSourceWithReader(audioAsset->createReader());
+    shiftyLooper.setAsset(audioAsset);
+    waveform->setAsset(*audioAsset);
     waveform->setBounds(20, 80, getWidth() - 60, getHeight()/6.0f);
 
     std::vector<std::string> vals = {
@@ -579,18 +627,62 @@ void AudioApp::initialize(){
     BackgroundThread progressWindow(10,vals);
     if (progressWindow.runThread()){
         audiofilename = static_cast<std::string>(auxFile->getFullPathName().toUTF8());
-        createdLoops  = lgen::constructLoops(lgen::initAudio(audiofilename));
-        markov_chain  = mkov::generateMarkovChain(createdLoops, MarkovIterations,
-                                                 random.nextInt(createdLoops.size()));
-        //currentLoop   = &createdLoops[random.nextInt(createdLoops.size())];
-        currentLoop = &createdLoops[markov_chain[0]];
+        //only needed until the loops and caches are built; afterwards the asset is
+        //the one resident copy of the file
+        lgen::SampleStore::Ptr sampleStore = lgen::initAudio(*audioAsset);
+        createdLoops  = lgen::constructLoops(sampleStore);
+        //the walk is generated lazily, for as long as playback lasts
+        shiftyLooper.clearLayers();
+        loopLayers.clear();
+        shiftyLooper.setGenerator(nullptr, 0);
+        shiftyLooper.setSplicePlanner(nullptr);
+        splicePlanner = nullptr;
+        markovGenerator = nullptr;
+        deletedLoops.clear();
+        markovModel   = new mkov::MarkovChain(createdLoops);
+        markovModel->computeDistances();
+        markovModel->learnSourceOrder();
+        if (sampleStore != nullptr){
+            boundaries = new BoundaryCache(*sampleStore, createdLoops);
+            markovModel->blendSpliceCosts(*boundaries);
+            //cut points and fades are planned in the background; hard cuts until then
+            splicePlanner = new SplicePlanner(audioAsset, createdLoops,
+                                              markovModel->getTransitionGraph(), *boundaries);
+            shiftyLooper.setSplicePlanner(splicePlanner);
+        }
+        markovModel->setShiftiness(static_cast<float>(shiftinessSlider->getValue()));
+       #if SHIFTY_RUN_BENCHMARKS
+        mkov::FeatureMatrix::benchmark();
+        mkov::MarkovChain::benchmarkWalk(markovModel->getTransitionGraph());
+        mkov::VariableOrderModel::benchmark(markovModel->getAliasTable());
+        LoopSamplerSource::benchmark(audioAsset);
+       #endif
+        if (!createdLoops.empty()){
+            const int startLoop = random.nextInt((int) createdLoops.size());
+            //a quarter of the steps carry on a phrase of the source track
+            markovGenerator = new mkov::MarkovGenerator(markovModel->getAliasTable(), startLoop,
+                                                        markovModel->getSourcePhrases(), 0.25f);
+            shiftyLooper.setGenerator(markovGenerator, startLoop);
+            //currentLoop   = &createdLoops[random.nextInt(createdLoops.size())];
+            currentLoop = &createdLoops[startLoop];
+        }
+       #if SHIFTY_LAYERED_LOOPING
+        if (sampleStore != nullptr){
+            for (int f = 0; f < LoopLayer::numDefaultFilters && f < ShiftyLooper::maxLayers - 1; ++f){
+                LoopLayer* layer = loopLayers.add(new LoopLayer(createdLoops, LoopLayer::defaultFilters[f],
+                                                                *boundaries, audioAsset, random));
+                if (!layer->isEmpty())
+                    shiftyLooper.addLayer(layer->getGenerator(), layer->getLoops(), layer->getSplicePlanner(),
+                                          layer->getStartLoop(), layer->getGain());
+            }
+        }
+       #endif
     } else
         progressWindow.threadComplete(true);
 
     verb.setSampleRate(44100.0);
 
     shiftyLooper.setShifting(true);
-    shiftyLooper.setMarkov(markov_chain);
     shiftyLooper.setLoops(createdLoops);
 
     shiftyLooper.setPosition(0.0);
@@ -678,9 +770,11 @@ void AudioApp::changeState(TransportState newState){
                 printCurrentState(String("Paused"));
                 playButton->setButtonText("Resume");
                 stopButton->setButtonText("Return to Beggining");
+                enablePlaybackSettings(true);
                 break;
             case Stopping:
                 printCurrentState(String("Stopping..."));
+                shiftyLooper.logTimingStats();
                 if (shiftyLooper.isLooping()) shiftyLooper.setLooping(false);
                 shiftyLooper.stop();
                 break;
@@ -690,6 +784,7 @@ void AudioApp::changeState(TransportState newState){
                 stopButton->setButtonText("Stop");
                 stopButton->setEnabled(false);
                 loopButton->setEnabled(true);
+                enablePlaybackSettings(true);
                 shiftyLooper.setPosition(0.0);
                 stopTimer();
                 break;
@@ -710,6 +805,7 @@ void AudioApp::changeState(TransportState newState){
                 playButton->setButtonText("Pause");
                 stopButton->setButtonText("Stop");
                 waveform->isShiftyLooping(true);
+                enablePlaybackSettings(false);
                 shifting = true;
                 shiftyLooper.shiftyLooping();
                 break;
@@ -720,6 +816,15 @@ void AudioApp::changeState(TransportState newState){
 }
 
 
+//shifty looping plays from the sampler, which the SoundTouch settings don't reach
+void AudioApp::enablePlaybackSettings(bool shouldBeEnabled){
+    pitchSlider->setEnabled(shouldBeEnabled);
+    tempoSlider->setEnabled(shouldBeEnabled);
+    rateSlider->setEnabled(shouldBeEnabled);
+    //nor the master gain: there each segment carries it, in step with the walk
+    sourcePlayer.setGain(shouldBeEnabled ? gain : 1.0f);
+}
+
 //==============================================================================
 void AudioApp::playerStoppedOrStarted(drow::AudioFilePlayer* player){
     if (player == &shiftyLooper){
@@ -767,9 +872,20 @@ void AudioApp::showLoopTable(){
     }
 }
 
-inline void AudioApp::removeLoop(int index){
-    deletedLoops.push_back(createdLoops[index]);
-    createdLoops.erase(createdLoops.begin() + index);
+void AudioApp::removeLoop(int index){
+    //loops keep their index so the transition graph and the queued walk stay valid
+    if (markovModel == nullptr || std::find(deletedLoops.begin(), deletedLoops.end(), index) != deletedLoops.end())
+        return;
+    deletedLoops.push_back(index);
+    markovModel->removeLoop(index);
+}
+
+void AudioApp::restoreLoop(int index){
+    auto deleted = std::find(deletedLoops.begin(), deletedLoops.end(), index);
+    if (markovModel == nullptr || deleted == deletedLoops.end())
+        return;
+    deletedLoops.erase(deleted);
+    markovModel->restoreLoop(index);
 }
 
 void AudioApp::playLoop(int index){
@@ -795,8 +911,9 @@ void AudioApp::audioFilePlayerSettingChanged(drow::AudioFilePlayer* player,
 
 
 void AudioApp::timerCallback(){
+    //loop switches run on the audio thread; this only (re)arms them
     shifting = true;
-    shifty_looping();
+    shiftyLooper.shiftyLooping();
 }
 
 //[/MiscUserCode]
@@ -942,6 +1059,16 @@ BEGIN_JUCER_METADATA
          editableSingleClick="0" editableDoubleClick="0" focusDiscardsChanges="0"
          fontname="Arial Black" fontsize="22.300000000000000711" bold="0"
          italic="0" justification="36"/>
+  <SLIDER name="Shiftiness" id="3b7e0c94d1a6f258" memberName="shiftinessSlider"
+          virtualName="" explicitFocusOrder="0" pos="448 472 168 24" bkgcol="450707"
+          min="0.10000000000000000555" max="4" int="0" style="LinearHorizontal"
+          textBoxPos="NoTextBox" textBoxEditable="0" textBoxWidth="80"
+          textBoxHeight="20" skewFactor="0.5"/>
+  <LABEL name="Shiftiness Label" id="c52f9a1e07d46b83" memberName="shiftinessLabel"
+         virtualName="" explicitFocusOrder="0" pos="352 472 96 24" textCol="fff0ffff"
+         edTextCol="ff000000" edBkgCol="0" labelText="Shiftiness" editableSingleClick="0"
+         editableDoubleClick="0" focusDiscardsChanges="0" fontname="Arial Black"
+         fontsize="15" bold="0" italic="0" justification="33"/>
 </JUCER_COMPONENT>
 
 END_JUCER_METADATA
@@ -24,8 +24,8 @@
 #include "JuceHeader.h"
 #include "LoopGenerator.h"
 #include "MarkovChain.h"
-#include "MATRIX.h"
 #include "ShiftyLooping.h"
+#include "LoopLayer.h"
 #include "Design.h"
 #include "AudioWaveform.h"
 #include "AudioRecorder.h"
@@ -74,6 +74,7 @@ public:
 
     //State Methods
     void changeState(TransportState newState);
+    void enablePlaybackSettings(bool shouldBeEnabled);
     void printCurrentState(String s);
 
     //File Player Methods
@@ -98,6 +99,7 @@ public:
     
     //Table Button Operations
     void removeLoop(int index);
+    void restoreLoop(int index);
     void playLoop(int index);
     //[/UserMethods]
 
@@ -136,14 +138,17 @@ private:
     TransportState state;
     Loop* currentLoop;
     std::vector<Loop> createdLoops;
+    lgen::AudioAsset::Ptr audioAsset;
     bool shifting, forward;
     std::string audiofilename;
 
     //Distance and Markov Vars
     const int MarkovIterations;
-    MATRIX* similarity;
-    juce::ScopedPointer<MATRIX> transMat;
-    std::vector<int> markov_chain;
+    juce::ScopedPointer<mkov::MarkovChain> markovModel;
+    juce::ScopedPointer<mkov::MarkovGenerator> markovGenerator;
+    juce::ScopedPointer<BoundaryCache> boundaries;
+    juce::ScopedPointer<SplicePlanner> splicePlanner;
+    juce::OwnedArray<LoopLayer> loopLayers;
 
     //effects Vars
     BufferTransform bufferTransform;
@@ -157,7 +162,7 @@ private:
     juce::Random random;
     juce::Logger* masterLogger;
     MemoryInputStream stream;
-    std::vector<Loop> deletedLoops;
+    std::vector<int> deletedLoops;
 
 
     //Views
@@ -196,6 +201,8 @@ private:
     ScopedPointer<ToggleButton> reverbButton;
     ScopedPointer<Slider> delaySlider;
     ScopedPointer<Label> delayLabel;
+    ScopedPointer<Slider> shiftinessSlider;
+    ScopedPointer<Label> shiftinessLabel;
 
 
     //==============================================================================
@@ -0,0 +1,207 @@
+/*
+  ==============================================================================
+
+    AudioAsset.cpp
+    Created: 17 Oct 2026 8:24:10pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "AudioAsset.h"
+
+namespace lgen{
+
+//Serves an AudioAsset's float samples through the AudioFormatReader interface
+class AudioAssetReader : public AudioFormatReader {
+public:
+    explicit AudioAssetReader(const AudioAsset* a) :
+        AudioFormatReader(nullptr, "AudioAsset"), asset(const_cast<AudioAsset*>(a))
+    {
+        sampleRate            = asset->getSampleRate();
+        bitsPerSample         = 32;
+        lengthInSamples       = asset->getNumSamples();
+        numChannels           = static_cast<unsigned int>(asset->getNumChannels());
+        usesFloatingPointData = true;
+    }
+
+    bool readSamples(int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                     int64 startSampleInFile, int numSamples) override {
+        clearSamplesBeyondAvailableLength(destSamples, numDestChannels, startOffsetInDestBuffer,
+                                          startSampleInFile, numSamples, lengthInSamples);
+        if (numSamples <= 0)
+            return true;
+
+        asset->read(reinterpret_cast<float* const*>(destSamples), numDestChannels, startOffsetInDestBuffer,
+                    static_cast<int>(startSampleInFile), numSamples);
+        return true;
+    }
+
+private:
+    const AudioAsset::Ptr asset;
+};
+
+static bool isUsable(const AudioFormatReader* reader){
+    return reader != nullptr && reader->lengthInSamples > 0 && reader->numChannels > 0
+            && reader->sampleRate > 0.0 && reader->lengthInSamples <= std::numeric_limits<int>::max();
+}
+
+AudioAsset::AudioAsset(const File& f, double sr, int channels, int length) :
+    file(f), sampleRate(sr), numChannels(channels), numSamples(length)
+{
+}
+
+AudioAsset::Ptr AudioAsset::createFromFile(const File& file){
+    //WAV: map the file and convert samples as they are read, nothing is decoded up front
+    WavAudioFormat wav;
+    ScopedPointer<MemoryMappedAudioFormatReader> mapped(wav.createMemoryMappedReader(file));
+    if (isUsable(mapped) && mapped->mapEntireFile()){
+        Ptr asset = new AudioAsset(file, mapped->sampleRate, static_cast<int>(mapped->numChannels),
+                                   static_cast<int>(mapped->lengthInSamples));
+        asset->mapped = mapped.release();
+        return asset;
+    }
+
+    AudioFormatManager formats;
+    formats.registerBasicFormats();
+    ScopedPointer<AudioFormatReader> reader(formats.createReaderFor(file));
+    if (!isUsable(reader))
+        return nullptr;
+
+    const int length = static_cast<int>(reader->lengthInSamples);
+    Ptr asset = new AudioAsset(file, reader->sampleRate, static_cast<int>(reader->numChannels), length);
+    asset->buffer.setSize(asset->numChannels, length);
+    reader->read(&asset->buffer, 0, length, 0, true, true);
+    return asset;
+}
+
+AudioAsset::Ptr AudioAsset::createFromBuffer(const AudioSampleBuffer& samples, double sampleRate){
+    if (samples.getNumSamples() <= 0 || samples.getNumChannels() == 0 || sampleRate <= 0.0)
+        return nullptr;
+
+    Ptr asset = new AudioAsset(File::nonexistent, sampleRate, samples.getNumChannels(), samples.getNumSamples());
+    asset->buffer = samples;
+    return asset;
+}
+
+void AudioAsset::read(float* const* dest, int numDestChannels, int destStart,
+                      int startSample, int numToRead) const noexcept {
+    //only [first, last) exists; whatever falls outside it is silence
+    const int first = jlimit(0, numSamples, startSample);
+    const int last  = jlimit(first, numSamples, startSample + numToRead);
+    const int lead  = jmin(numToRead, first - startSample);
+    const int numChannelsRead = jmin(numChannels, numDestChannels);
+
+    for (int c = 0; c < numDestChannels; ++c){
+        if (dest[c] == nullptr) continue;
+        if (c >= numChannelsRead){
+            FloatVectorOperations::clear(dest[c] + destStart, numToRead);
+            continue;
+        }
+        FloatVectorOperations::clear(dest[c] + destStart, lead);
+        FloatVectorOperations::clear(dest[c] + destStart + lead + (last - first), numToRead - lead - (last - first));
+        if (mapped == nullptr && last > first)
+            FloatVectorOperations::copy(dest[c] + destStart + lead, buffer.getReadPointer(c, first), last - first);
+    }
+
+    if (mapped != nullptr && last > first){
+        int** channels = reinterpret_cast<int**>(const_cast<float**>(dest));
+        mapped->readSamples(channels, numChannelsRead, destStart + lead, first, last - first);
+        if (!mapped->usesFloatingPointData)
+            for (int c = 0; c < numChannelsRead; ++c)
+                if (dest[c] != nullptr)
+                    FloatVectorOperations::convertFixedToFloat(dest[c] + destStart + lead, channels[c] + destStart + lead,
+                                                               1.0f / 0x7fffffff, last - first);
+    }
+}
+
+AudioFormatReader* AudioAsset::createReader() const {
+    return new AudioAssetReader(this);
+}
+
+void AudioAsset::fillThumbnail(AudioThumbnail& thumbnail) const {
+    thumbnail.reset(numChannels, sampleRate, numSamples);
+    if (mapped == nullptr){
+        thumbnail.addBlock(0, buffer, 0, numSamples);
+        return;
+    }
+
+    AudioSampleBuffer block(numChannels, readBlockSize);
+    for (int start = 0; start < numSamples; start += readBlockSize){
+        const int num = jmin((int) readBlockSize, numSamples - start);
+        read(block.getArrayOfWritePointers(), numChannels, 0, start, num);
+        thumbnail.addBlock(start, block, 0, num);
+    }
+}
+
+SampleStore::Ptr AudioAsset::createSampleStore(double targetSampleRate) const {
+    return SampleStore::createFromAsset(*this, targetSampleRate);
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class AudioAssetTests : public UnitTest {
+public:
+    AudioAssetTests() : UnitTest("AudioAsset") {}
+
+    void runTest() override {
+        beginTest("Mapped WAV reads like the decoded file");
+
+        const int length = 3000;
+        AudioSampleBuffer source(2, length);
+        Random random(0xa55e7);
+        for (int c = 0; c < 2; ++c)
+            for (int n = 0; n < length; ++n)
+                source.setSample(c, n, random.nextFloat() * 2.0f - 1.0f);
+
+        TemporaryFile temp(".wav");
+        {
+            WavAudioFormat wav;
+            ScopedPointer<AudioFormatWriter> writer(wav.createWriterFor(new FileOutputStream(temp.getFile()),
+                                                                        48000.0, 2, 16, StringPairArray(), 0));
+            expect(writer != nullptr);
+            if (writer == nullptr) return;
+            writer->writeFromAudioSampleBuffer(source, 0, length);
+        }
+
+        AudioFormatManager formats;
+        formats.registerBasicFormats();
+        ScopedPointer<AudioFormatReader> reader(formats.createReaderFor(temp.getFile()));
+        expect(reader != nullptr);
+        if (reader == nullptr) return;
+        AudioSampleBuffer decoded(2, length);
+        reader->read(&decoded, 0, length, 0, true, true);
+        reader = nullptr;
+
+        const AudioAsset::Ptr asset = AudioAsset::createFromFile(temp.getFile());
+        expect(asset != nullptr && asset->isMapped());
+        if (asset == nullptr) return;
+        expectEquals(asset->getNumChannels(), 2);
+        expectEquals(asset->getNumSamples(), length);
+        expect(asset->getDecodedBuffer() == nullptr);
+
+        //runs off both ends, and asks for a third channel the file doesn't have
+        const int start = -100, num = length + 200;
+        AudioSampleBuffer read(3, num + 10);
+        read.clear();
+        asset->read(read.getArrayOfWritePointers(), 3, 10, start, num);
+
+        int mismatches = 0;
+        for (int c = 0; c < 3; ++c){
+            for (int n = 0; n < num; ++n){
+                const int s = start + n;
+                const float expected = (c < 2 && s >= 0 && s < length) ? decoded.getSample(c, s) : 0.0f;
+                mismatches += read.getSample(c, 10 + n) == expected ? 0 : 1;
+            }
+        }
+        expectEquals(mismatches, 0);
+        expectEquals(read.getSample(0, 0), 0.0f);
+    }
+};
+
+static AudioAssetTests audioAssetTests;
+
+#endif
+
+}
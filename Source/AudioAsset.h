@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    AudioAsset.h
+    Created: 17 Oct 2026 8:24:10pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef AUDIOASSET_H_INCLUDED
+#define AUDIOASSET_H_INCLUDED
+
+#include "JuceHeader.h"
+#include "SampleStore.h"
+
+namespace lgen{
+
+/*
+    A loaded audio file at its own sample rate and channel count. WAV files
+    are memory-mapped and converted to float only as they are read, so the
+    file's pages (which the OS can drop and fetch again) are the only copy;
+    other formats are decoded once into a float buffer. Playback, the
+    waveform thumbnail and analysis all read from here through read() instead
+    of opening the file again: the player streams it through createReader(),
+    the thumbnail is filled with fillThumbnail() and the mono analysis samples
+    come from createSampleStore().
+*/
+class AudioAsset : public ReferenceCountedObject {
+public:
+    typedef ReferenceCountedObjectPtr<AudioAsset> Ptr;
+
+    //for walking the whole file through read()
+    enum { readBlockSize = 1 << 16 };
+
+    static Ptr createFromFile(const File& file);
+    /** Samples already in memory, e.g. synthesised ones; they are copied. */
+    static Ptr createFromBuffer(const AudioSampleBuffer& samples, double sampleRate);
+
+    const File& getFile()                const noexcept { return file; }
+    double getSampleRate()               const noexcept { return sampleRate; }
+    int    getNumChannels()              const noexcept { return numChannels; }
+    int    getNumSamples()               const noexcept { return numSamples; }
+    double getLengthInSeconds()          const noexcept { return numSamples / sampleRate; }
+    bool   isMapped()                    const noexcept { return mapped != nullptr; }
+
+    /** Writes numToRead samples from startSample into dest[c] + destStart for
+        the first numDestChannels channels, skipping null ones. Channels and
+        samples beyond the asset read as silence. It never allocates or locks,
+        so the render thread may call it; a mapped page the OS has dropped is
+        read back from the file, as with any memory-mapped reader. */
+    void read(float* const* dest, int numDestChannels, int destStart,
+              int startSample, int numToRead) const noexcept;
+
+    /** The decoded samples, or nullptr when the file is mapped. */
+    const AudioSampleBuffer* getDecodedBuffer() const noexcept { return mapped == nullptr ? &buffer : nullptr; }
+
+    /** A reader over the decoded samples; it keeps the asset alive. The caller
+        (e.g. drow::AudioFilePlayer::setSourceWithReader) takes ownership. */
+    AudioFormatReader* createReader() const;
+
+    void fillThumbnail(AudioThumbnail& thumbnail) const;
+
+    /** The mono analysis samples at targetSampleRate: the decoded buffer itself
+        for mono files already at that rate, otherwise a downmixed (and
+        resampled) copy read block by block. */
+    SampleStore::Ptr createSampleStore(double targetSampleRate = 44100.0) const;
+
+private:
+    AudioAsset(const File& f, double sr, int channels, int length);
+
+    const File file;
+    const double sampleRate;
+    const int numChannels, numSamples;
+    ScopedPointer<MemoryMappedAudioFormatReader> mapped;    //WAV files
+    AudioSampleBuffer buffer;                               //everything else
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioAsset)
+};
+
+}
+
+#endif  // AUDIOASSET_H_INCLUDED
@@ -37,14 +37,13 @@ Waveform::~Waveform(){
         thumbnail.removeChangeListener(this);
     }
     
-void Waveform::setFile(const File& file){
-        if (!file.isDirectory()) {
-            thumbnail.setSource(new FileInputSource(file));
-            const Range<double> newRange(0.0, thumbnail.getTotalLength());
-            scrollbar.setRangeLimits(newRange);
-            setRange(newRange);
-            startTimer(1000/40);
-        }
+void Waveform::setAsset(const lgen::AudioAsset& asset){
+        //drawn from the asset's samples rather than a second reader over the file
+        asset.fillThumbnail(thumbnail);
+        const Range<double> newRange(0.0, thumbnail.getTotalLength());
+        scrollbar.setRangeLimits(newRange);
+        setRange(newRange);
+        startTimer(1000/40);
     }
     
 void Waveform::setZoomFactor(double amount){
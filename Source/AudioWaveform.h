@@ -12,6 +12,7 @@
 #define AUDIOWAVEFORM_H_INCLUDED
 
 #include "JuceHeader.h"
+#include "AudioAsset.h"
 
 class Waveform :
 public Component,
@@ -25,7 +26,7 @@ public:
     explicit Waveform(drow::AudioFilePlayerExt& afp);
     ~Waveform();
     
-    void setFile(const File& file);
+    void setAsset(const lgen::AudioAsset& asset);
     void setZoomFactor(double amount);
     
     void setRange(Range<double> newRange);
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    BeatGrid.cpp
+    Created: 17 Oct 2026 6:02:25pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "BeatGrid.h"
+
+using namespace essentia;
+using namespace essentia::standard;
+
+//made once: "rhythm.intervals" is longer than some libraries' short-string
+//buffer, and a temporary key would allocate on every set()
+static const std::string bpmKey("rhythm.bpm"), beatsKey("rhythm.beats"),
+                         confKey("rhythm.conf"), intervalsKey("rhythm.intervals");
+
+BeatGrid::BeatGrid() : bpm(0), confidence(0)
+{
+}
+
+BeatGrid::~BeatGrid(){}
+
+void BeatGrid::compute(const VEC_REAL& signal){
+    AlgorithmFactory& factory = essentia::standard::AlgorithmFactory::instance();
+    juce::ScopedPointer<Algorithm> rhythmXtractor = factory.create("RhythmExtractor2013");
+
+    VEC_REAL estimates;
+
+    rhythmXtractor->input("signal").set(signal);
+    rhythmXtractor->output("bpm").set(bpm);
+    rhythmXtractor->output("ticks").set(ticks);
+    rhythmXtractor->output("confidence").set(confidence);
+    rhythmXtractor->output("estimates").set(estimates);
+    rhythmXtractor->output("bpmIntervals").set(bpmIntervals);
+
+    rhythmXtractor->compute();
+}
+
+Range<int> BeatGrid::getTickRange(_REAL startSecs, _REAL endSecs) const noexcept {
+    const int first = static_cast<int>(std::lower_bound(ticks.begin(), ticks.end(), startSecs) - ticks.begin());
+    const int last  = static_cast<int>(std::lower_bound(ticks.begin(), ticks.end(), endSecs)   - ticks.begin());
+    return Range<int>(first, jmax(first, last));
+}
+
+void BeatGrid::reserve(Scratch& scratch) const {
+    scratch.beats.reserve(ticks.size());
+    scratch.intervals.reserve(ticks.size());
+}
+
+_REAL BeatGrid::getBpm(_REAL startSecs, _REAL endSecs, VEC_REAL& intervals) const {
+    //widen by a tick either side so a short loop still spans a couple of intervals
+    const Range<int> range(getTickRange(startSecs, endSecs));
+    const int first = jmax(0, range.getStart() - 1);
+    const int last  = jmin(static_cast<int>(ticks.size()), range.getEnd() + 1);
+    if (last - first < 3)
+        return bpm;
+
+    intervals.resize(static_cast<size_t>(last - first - 1));
+    for (int i = first; i < last - 1; ++i)
+        intervals[i - first] = ticks[i + 1] - ticks[i];
+
+    std::nth_element(intervals.begin(), intervals.begin() + intervals.size() / 2, intervals.end());
+    const _REAL median = intervals[intervals.size() / 2];
+    return median > 0 ? 60.0f / median : bpm;
+}
+
+void BeatGrid::describeRange(_REAL startSecs, _REAL endSecs, Scratch& scratch, Pool& bin) const {
+    const Range<int> range(getTickRange(startSecs, endSecs));
+    const _REAL loopBpm = getBpm(startSecs, endSecs, scratch.intervals);
+
+    VEC_REAL& beats     = scratch.beats;
+    VEC_REAL& intervals = scratch.intervals;
+    beats.clear();
+    intervals.clear();
+    for (int i = range.getStart(); i < range.getEnd(); ++i){
+        beats.push_back(ticks[i] - startSecs);
+        if (i > range.getStart())
+            intervals.push_back(ticks[i] - ticks[i - 1]);
+    }
+
+    //the tracker's confidence is for the whole file; discount loops where it
+    //found fewer beats than the tempo implies
+    const _REAL expected = (endSecs - startSecs) * loopBpm / 60.0f;
+    const _REAL coverage = expected > 0 ? jmin(1.0f, range.getLength() / expected) : 0.0f;
+
+    bin.set(bpmKey, loopBpm);
+    bin.set(beatsKey, beats);
+    bin.set(confKey, confidence * coverage);
+    bin.set(intervalsKey, intervals);
+}
+
+void BeatGrid::reserveRange(_REAL startSecs, _REAL endSecs, Pool& bin) const {
+    const int numBeats = getTickRange(startSecs, endSecs).getLength();
+    bin.set(bpmKey, _REAL(0));
+    bin.set(beatsKey, VEC_REAL(static_cast<size_t>(numBeats)));
+    bin.set(confKey, _REAL(0));
+    bin.set(intervalsKey, VEC_REAL(static_cast<size_t>(jmax(0, numBeats - 1))));
+}
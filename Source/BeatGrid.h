@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    BeatGrid.h
+    Created: 17 Oct 2026 6:02:25pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef BEATGRID_H_INCLUDED
+#define BEATGRID_H_INCLUDED
+
+#include "JuceHeader.h"
+#include "essentia.h"
+#include "pool.h"
+#include "algorithmfactory.h"
+#include "SampleStore.h"
+
+/*
+    The beat tracker's view of a whole file. RhythmExtractor2013 runs once on
+    the full signal; a loop's tempo, beats and confidence are then read off the
+    global ticks that fall inside it. Tracking a one-second excerpt on its own
+    sees two or three beats at most, so this is both cheaper and steadier.
+*/
+class BeatGrid {
+public:
+    BeatGrid();
+    ~BeatGrid();
+
+    void compute(const VEC_REAL& signal);
+
+    const VEC_REAL& getTicks()  const noexcept { return ticks; }
+    _REAL getBpm()              const noexcept { return bpm; }
+    _REAL getConfidence()       const noexcept { return confidence; }
+
+    /** Indices of the ticks in [startSecs, endSecs). */
+    Range<int> getTickRange(_REAL startSecs, _REAL endSecs) const noexcept;
+
+    /** What describeRange() works in. Give each thread its own and reserve()
+        it once; describing a range then never allocates. */
+    struct Scratch {
+        VEC_REAL beats, intervals;
+    };
+    void reserve(Scratch& scratch) const;
+
+    /** Tempo from the median beat interval around the range, falling back on
+        the global tempo when there are too few beats to tell. intervals is
+        overwritten. */
+    _REAL getBpm(_REAL startSecs, _REAL endSecs, VEC_REAL& intervals) const;
+
+    /** Sets rhythm.bpm, rhythm.beats (relative to startSecs), rhythm.conf and
+        rhythm.intervals for the range. */
+    void describeRange(_REAL startSecs, _REAL endSecs, Scratch& scratch, essentia::Pool& bin) const;
+
+    /** Creates describeRange()'s entries in bin at their final sizes, so
+        describing the range later only overwrites them. */
+    void reserveRange(_REAL startSecs, _REAL endSecs, essentia::Pool& bin) const;
+
+private:
+    VEC_REAL ticks, bpmIntervals;
+    _REAL bpm, confidence;
+
+    BeatGrid(const BeatGrid&);
+    BeatGrid& operator=(const BeatGrid&);
+};
+
+
+#endif  // BEATGRID_H_INCLUDED
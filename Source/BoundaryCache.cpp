@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    BoundaryCache.cpp
+    Created: 18 Oct 2026 4:05:32pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "BoundaryCache.h"
+#include "algorithmfactory.h"
+
+using namespace essentia;
+using namespace essentia::standard;
+
+static void uniquePositions(std::vector<int>& positions){
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+}
+
+static int positionIndex(const std::vector<int>& positions, int pos){
+    return static_cast<int>(std::lower_bound(positions.begin(), positions.end(), pos) - positions.begin());
+}
+
+BoundaryCache::BoundaryCache(const lgen::SampleStore& store, const std::vector<Loop>& loops)
+{
+    std::vector<int> headStarts, tailStarts;
+    headStarts.reserve(loops.size());
+    tailStarts.reserve(loops.size());
+    for (auto& loop : loops){
+        headStarts.push_back(loop.sampsStart);
+        tailStarts.push_back(loop.sampsEnd - frameSize);
+    }
+    uniquePositions(headStarts);
+    uniquePositions(tailStarts);
+
+    headIndex.reserve(loops.size());
+    tailIndex.reserve(loops.size());
+    for (auto& loop : loops){
+        headIndex.push_back(positionIndex(headStarts, loop.sampsStart));
+        tailIndex.push_back(positionIndex(tailStarts, loop.sampsEnd - frameSize));
+    }
+
+    analysePositions(store, headStarts, heads);
+    analysePositions(store, tailStarts, tails);
+
+    Logger::writeToLog("Boundary cache: " + String((int) loops.size()) + " loops, "
+                       + String(getNumHeads()) + " heads, " + String(getNumTails()) + " tails");
+}
+
+BoundaryCache::BoundaryCache(const BoundaryCache& source, const std::vector<int>& loopIds) :
+    heads(source.heads), tails(source.tails)
+{
+    headIndex.reserve(loopIds.size());
+    tailIndex.reserve(loopIds.size());
+    for (int id : loopIds){
+        headIndex.push_back(source.headIndex[id]);
+        tailIndex.push_back(source.tailIndex[id]);
+    }
+}
+
+BoundaryCache::~BoundaryCache(){}
+
+void BoundaryCache::analysePositions(const lgen::SampleStore& store, const std::vector<int>& firstSamples,
+                                     std::vector<float>& dest){
+    AlgorithmFactory& factory = essentia::standard::AlgorithmFactory::instance();
+    juce::ScopedPointer<Algorithm>
+            _w    = factory.create("Windowing", "type", "hann"),
+            _spec = factory.create("Spectrum"),
+            _rms  = factory.create("RMS");
+
+    VEC_REAL frame(frameSize), windowedFrame, spectrum;
+    Real rms;
+    _w   ->input("frame").set(frame);
+    _w   ->output("frame").set(windowedFrame);
+    _spec->input("frame").set(windowedFrame);
+    _spec->output("spectrum").set(spectrum);
+    _rms ->input("array").set(frame);
+    _rms ->output("rms").set(rms);
+
+    //log-spaced band edges over the frameSize / 2 + 1 bins, DC left out
+    const int numBins = frameSize / 2 + 1;
+    int edges[numBands + 1];
+    edges[0] = 1;
+    for (int b = 1; b <= numBands; ++b)
+        edges[b] = jmax(edges[b - 1] + 1, roundToInt(std::pow((double) numBins, (double) b / numBands)));
+    edges[numBands] = numBins;
+
+    dest.resize(firstSamples.size() * stride);
+    float* out = dest.data();
+    for (int first : firstSamples){
+        //frames running off either end of the file are zero padded
+        std::fill(frame.begin(), frame.end(), 0.0f);
+        const int begin = jmax(0, first), end = jmin(store.size(), first + (int) frameSize);
+        if (begin < end)
+            std::copy(store.getData() + begin, store.getData() + end, frame.begin() + (begin - first));
+
+        _w->compute();
+        _spec->compute();
+        _rms->compute();
+
+        out[0] = Decibels::gainToDecibels(rms, -100.0f);
+        for (int b = 0; b < numBands; ++b){
+            float energy = 0.0f;
+            for (int k = edges[b]; k < jmin(edges[b + 1], (int) spectrum.size()); ++k)
+                energy += spectrum[k] * spectrum[k];
+            out[1 + b] = jmax(-100.0f, 10.0f * std::log10(energy + 1.0e-10f));
+        }
+        out += stride;
+    }
+}
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    BoundaryCache.h
+    Created: 18 Oct 2026 4:05:32pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef BOUNDARYCACHE_H_INCLUDED
+#define BOUNDARYCACHE_H_INCLUDED
+
+#include <vector>
+#include "JuceHeader.h"
+#include "SampleStore.h"
+#include "LoopGenerator.h"
+
+/*
+    What each loop sounds like right at its splice points: a short frame
+    starting at the loop's first sample (its head) and one ending at its last
+    (its tail), each reduced to RMS and a few log-spaced band levels, in dB.
+    Loops cut at the same onset share a boundary, so every distinct head and
+    tail position is analysed once; the whole cache is two small FFTs per
+    position. spliceCost(i, j) is how audible the jump from the end of loop i
+    to the start of loop j should be.
+*/
+class BoundaryCache {
+public:
+    enum { frameSize = 1024, numBands = 16 };
+
+    BoundaryCache(const lgen::SampleStore& store, const std::vector<Loop>& loops);
+    /** The same analysis seen through a subset of its loops: loop n here is
+        loop loopIds[n] of source. Nothing is analysed again. */
+    BoundaryCache(const BoundaryCache& source, const std::vector<int>& loopIds);
+    ~BoundaryCache();
+
+    /** Level jump plus mean band-level jump, in dB, from i's tail to j's head. */
+    float spliceCost(int from, int to) const noexcept {
+        const float* tail = tails.data() + tailIndex[from] * stride;
+        const float* head = heads.data() + headIndex[to] * stride;
+        float bands = 0.0f;
+        for (int b = 1; b < stride; ++b)
+            bands += std::abs(tail[b] - head[b]);
+        return std::abs(tail[0] - head[0]) + bands / numBands;
+    }
+
+    int getNumHeads() const noexcept { return (int) heads.size() / stride; }
+    int getNumTails() const noexcept { return (int) tails.size() / stride; }
+
+private:
+    enum { stride = numBands + 1 };     //RMS then the bands
+
+    std::vector<float> heads, tails;
+    std::vector<int>   headIndex, tailIndex;
+
+    static void analysePositions(const lgen::SampleStore& store, const std::vector<int>& firstSamples,
+                                 std::vector<float>& dest);
+
+    BoundaryCache(const BoundaryCache&);
+    BoundaryCache& operator=(const BoundaryCache&);
+};
+
+
+#endif  // BOUNDARYCACHE_H_INCLUDED
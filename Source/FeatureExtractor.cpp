@@ -14,8 +14,40 @@
 using namespace essentia;
 using namespace essentia::standard;
 
-FeatureExtractor::FeatureExtractor(const VEC_REAL& buffer) :
-    AudioBuffer(buffer), SR(44100), FrameSize(2048), HopSize(FrameSize/2)
+/*
+    One per worker thread. Each job keeps pulling the next unclaimed loop until
+    none are left, so fast workers pick up the slack of slow ones. A loop's
+    features are only written into that loop's own Pool, so the result does not
+    depend on the number of threads or the order loops are claimed in.
+*/
+class LoopFeatureJob : public ThreadPoolJob {
+public:
+    LoopFeatureJob(FeatureExtractor& x, std::vector<Loop>& l, Atomic<int>& next) :
+        ThreadPoolJob("Loop features"), xtractor(x), loops(l), nextLoop(next) {}
+
+    JobStatus runJob() override {
+        //built on the worker so graph construction is spread across threads too
+        if (graph == nullptr)
+            graph = xtractor.createGraph();
+
+        const int numLoops = static_cast<int>(loops.size());
+        for (int i = ++nextLoop - 1; i < numLoops; i = ++nextLoop - 1){
+            if (shouldExit()) break;
+            xtractor.computeFeaturesForLoop(loops[i], *graph);
+        }
+        return jobHasFinished;
+    }
+
+private:
+    FeatureExtractor& xtractor;
+    std::vector<Loop>& loops;
+    Atomic<int>& nextLoop;
+    ScopedPointer<FeatureGraph> graph;
+};
+
+FeatureExtractor::FeatureExtractor(const lgen::SampleStore::Ptr& _store, FeatureRegistry& _registry) :
+    store(_store), registry(_registry), AudioBuffer(_store->samples()), SR(44100), FrameSize(2048), HopSize(FrameSize/2),
+    timeline(FrameSize, HopSize)
 
 {
     essentia::init();
@@ -27,150 +59,152 @@ FeatureExtractor::~FeatureExtractor(){
 
 void FeatureExtractor::computeFeaturesForBuffer(){
     AlgorithmFactory& factory = essentia::standard::AlgorithmFactory::instance();
-    juce::ScopedPointer<Algorithm> rhythmXtractor = factory.create("RhythmExtractor2013");
     juce::ScopedPointer<Algorithm> onsetDetector = factory.create("OnsetRate");
     
-    VEC_REAL estimates, bpmIntervals;
-    Real confidence, rate, bpm;
-    
-    rhythmXtractor->input("signal").set(AudioBuffer);
-    rhythmXtractor->output("bpm").set(bpm);
-    rhythmXtractor->output("ticks").set(beats);
-    rhythmXtractor->output("confidence").set(confidence);
-    rhythmXtractor->output("estimates").set(estimates);
-    rhythmXtractor->output("bpmIntervals").set(bpmIntervals);
+    Real rate;
     
     onsetDetector->input("signal").set(AudioBuffer);
     onsetDetector->output("onsets").set(onsets);
     onsetDetector->output("onsetRate").set(rate);
     
-    rhythmXtractor->compute();
     onsetDetector->compute();
 
+    //the only beat tracking pass; loops slice its ticks
+    if (registry.needs(FeatureRegistry::Rhythm)){
+        FeatureRegistry::ScopedTimer timer(registry, FeatureRegistry::Rhythm);
+        beatGrid.compute(AudioBuffer);
+    }
+
+    //whole-file STFT and HPCP, shared by every loop's spectral and tonal features.
+    //The STFT is shared, so it is billed to the frame tracks when they are needed
+    const bool withChroma = registry.needs(FeatureRegistry::Key);
+    if (withChroma || registry.needs(FeatureRegistry::FrameTracks)){
+        FeatureRegistry::ScopedTimer timer(registry, registry.needs(FeatureRegistry::FrameTracks)
+                                                     ? FeatureRegistry::FrameTracks : FeatureRegistry::Key);
+        timeline.compute(AudioBuffer, withChroma);
+    }
 }
 
-void FeatureExtractor::computeFeaturesForLoop(Loop& loop){
-    AlgorithmFactory& factory = essentia::standard::AlgorithmFactory::instance();
+void FeatureExtractor::addTimelineFeatures(int sampsStart, int sampsEnd, FeatureGraph& graph,
+                                           Pool& bin) const {
+    if (registry.needs(FeatureRegistry::FrameTracks)){
+        FeatureRegistry::ScopedTimer timer(registry, FeatureRegistry::FrameTracks);
+        const FeatureTimeline::Stats rms    = timeline.aggregate(FrameAnalysis::RMS,      sampsStart, sampsEnd);
+        const FeatureTimeline::Stats energy = timeline.aggregate(FrameAnalysis::Energy,   sampsStart, sampsEnd);
+        const FeatureTimeline::Stats cent   = timeline.aggregate(FrameAnalysis::Centroid, sampsStart, sampsEnd);
+
+        bin.set("dynam.rms",       rms.mean);
+        bin.set("dynam.rmsVar",    rms.variance);
+        bin.set("dynam.energy",    energy.mean);
+        bin.set("dynam.energyVar", energy.variance);
+        bin.set("timbre.cent",     cent.mean);
+        bin.set("timbre.centVar",  cent.variance);
+    }
+
+    //key from the loop's mean chroma instead of a TonalExtractor run per loop
+    if (registry.needs(FeatureRegistry::Key)){
+        FeatureRegistry::ScopedTimer timer(registry, FeatureRegistry::Key);
+        graph.computeKey(timeline, sampsStart, sampsEnd, bin);
+    }
+
+    if (registry.needs(FeatureRegistry::Rhythm)){
+        FeatureRegistry::ScopedTimer timer(registry, FeatureRegistry::Rhythm);
+        graph.describeRhythm(static_cast<_REAL>(sampsStart) / SR, static_cast<_REAL>(sampsEnd) / SR, bin);
+    }
+}
 
-    auto first = AudioBuffer.begin() + loop.sampsStart;
-    auto second = AudioBuffer.begin() + loop.sampsEnd;
-
-    VEC_REAL loopBuffer(first, second);
-   
-    juce::ScopedPointer<Algorithm>
-            _fc             = factory.create("FrameCutter", "frameSize", FrameSize,
-                                             "hopSize", HopSize),
-            _w              = factory.create("Windowing", "type", "hann"),
-            _spec           = factory.create("Spectrum"),
-            _cent           = factory.create("Centroid"),
-            _rms            = factory.create("RMS"),
-            _rhythmExt      = factory.create("RhythmExtractor2013"),
-            _dynam          = factory.create("DynamicComplexity"),
-            _tonalExtractor = factory.create("TonalExtractor");
-
-
-        VEC_REAL frame, windowedFrame, spectrum;
-
-        _fc      ->input("signal").set(loopBuffer);
-        _fc      ->output("frame").set(frame);
-        _w       ->input("frame").set(frame);
-        _w       ->output("frame").set(windowedFrame);
-        _spec    ->input("frame").set(windowedFrame);
-        _spec    ->output("spectrum").set(spectrum);
-
-        /* ========= RHYTHM FEATURES ===================== */
-        Real bpm, beatsConfidence;
-        VEC_REAL tempogram, beats, beatIntervals;
-
-        _rhythmExt->input("signal")       .set(loopBuffer);
-        _rhythmExt->output("bpm")         .set(bpm);
-        _rhythmExt->output("ticks")       .set(beats);
-        _rhythmExt->output("confidence")  .set(beatsConfidence);
-        _rhythmExt->output("bpmIntervals").set(beatIntervals);
-        _rhythmExt->output("estimates")   .set(tempogram);
-    
-        _rhythmExt->compute();
-    
-        loop.bin.set("rhythm.bpm", bpm);
-        loop.bin.set("rhythm.beats", beats);
-        loop.bin.set("rhythm.conf", beatsConfidence);
-        loop.bin.set("rhythm.intervals", beatIntervals);
-        loop.bin.set("rhythm.tempogram", tempogram);
-
-        /* ========= DYNAMICS FEATURES ===================== */
-        Real dynamicRangeCoeff, loudness, rms;
-
-        _rms    ->  input("array")             .set(frame);
-        _rms    ->  output("rms")              .set(rms);
-        _dynam  ->  input("signal")            .set(loopBuffer);
-        _dynam  ->  output("loudness")         .set(loudness);
-        _dynam  ->  output("dynamicComplexity").set(dynamicRangeCoeff);
-    
-        //Spectrum//
-        _fc->compute();
-        _w->compute();
-        _spec->compute();
-    
-        _dynam->compute();
-        _rms->compute();
-    
-        loop.bin.set("dynam.rms", rms);
-        loop.bin.set("dynam.loud", loudness);
-        loop.bin.set("dynam.dyRange", dynamicRangeCoeff);
-    
-        /* ========= TIMBRAL FEATURES ===================== */
-       // VEC_REAL mfccBands, mfccs;
-        Real centroid;
-
-       // _mfcc->input("spectrum").set(spectrum);
-       // _mfcc->output("bands").set(mfccBands);
-       // _mfcc->output("mfcc").set(mfccs);
-        _cent->input("array").set(spectrum);
-        _cent->output("centroid").set(centroid);
-    
-        _cent->compute();
-    
-        loop.bin.set("timbre.cent", centroid);
-
-        /* ========= TONAL FEATURES ===================== */
-        Real                            chords_ChangeRate, chords_NumberRate;
-        Real                            key_Strength;
-        std::string                     chords_key, chords_Scale;
-        std::string                     key_Key, key_Scale;
-        VEC_REAL                        chords_Histogram,  chords_Strength;
-        std::vector<std::string>        chords_Progression;
-        std::vector<VEC_REAL>           hpcp, hpcp_HighRes;
-
-        _tonalExtractor->input("signal")              .set(loopBuffer);
-        _tonalExtractor->output("chords_changes_rate").set(chords_ChangeRate);
-        _tonalExtractor->output("chords_histogram")   .set(chords_Histogram);
-        _tonalExtractor->output("chords_key")         .set(chords_key);
-        _tonalExtractor->output("chords_number_rate") .set(chords_NumberRate);
-        _tonalExtractor->output("chords_progression") .set(chords_Progression);
-        _tonalExtractor->output("chords_scale")       .set(chords_Scale);
-        _tonalExtractor->output("chords_strength")    .set(chords_Strength);
-        _tonalExtractor->output("hpcp")               .set(hpcp);
-        _tonalExtractor->output("hpcp_highres")       .set(hpcp_HighRes);
-        _tonalExtractor->output("key_key")            .set(key_Key);
-        _tonalExtractor->output("key_scale")          .set(key_Scale);
-        _tonalExtractor->output("key_strength")       .set(key_Strength);
-
-        _tonalExtractor->compute();
-    
-        loop.bin.set("tonal.chordrate", chords_ChangeRate);
-        loop.bin.set("tonal.histo", chords_Histogram);
-        loop.bin.set("tonal.chordsKey", chords_key);
-        loop.bin.set("tonal.chordsNumberRate", chords_NumberRate);
-        loop.bin.set("tonal.chordScale", chords_Scale);
-        loop.bin.set("tonal.chordsStrength", chords_Strength);
-        loop.bin.set("tonal.key", key_Key);
-        loop.bin.set("tonal.scale", key_Scale);
-        loop.bin.set("tonal.keyStr", key_Strength);
+void FeatureExtractor::reserveFeatures(int sampsStart, int sampsEnd, const FeatureGraph& graph,
+                                       Pool& bin) const {
+    if (registry.needs(FeatureRegistry::FrameTracks)){
+        const char* const names[] = { "dynam.rms", "dynam.rmsVar", "dynam.energy",
+                                      "dynam.energyVar", "timbre.cent", "timbre.centVar" };
+        for (auto* name : names)
+            bin.set(name, Real(0));
+    }
+    graph.reserve(bin);
+    if (registry.needs(FeatureRegistry::Rhythm))
+        beatGrid.reserveRange(static_cast<_REAL>(sampsStart) / SR, static_cast<_REAL>(sampsEnd) / SR, bin);
+}
+
+void FeatureExtractor::addTimelineFeatures(Loop& loop){
+    addTimelineFeatures(loop.sampsStart, loop.sampsEnd, getSerialGraph(), loop.bin);
+}
+
+FeatureGraph& FeatureExtractor::getSerialGraph(){
+    if (serialGraph == nullptr)
+        serialGraph = createGraph();
+    return *serialGraph;
+}
+
+void FeatureExtractor::computeFeaturesForLoop(Loop& loop){
+    computeFeaturesForLoop(loop, getSerialGraph());
+}
 
+void FeatureExtractor::computeFeaturesForLoop(Loop& loop, FeatureGraph& graph){
+    //the Pool is the output, so its entries are made first, like reserving a
+    //vector; everything after that only overwrites them and copies no samples
+    reserveFeatures(loop.sampsStart, loop.sampsEnd, graph, loop.bin);
+
+    lgen::AllocationCounter allocations;
+    lgen::SampleView loopBuffer;
+    store->getView(loop.sampsStart, loop.sampsEnd, loopBuffer);
+    graph.compute(loopBuffer, loop.bin);
+    addTimelineFeatures(loop.sampsStart, loop.sampsEnd, graph, loop.bin);
+    loopAllocations += allocations.getCount();
 }
 
+void FeatureExtractor::computeFeaturesForLoops(std::vector<Loop>& loops, int numThreads){
+    numThreads = jlimit(1, jmax(1, static_cast<int>(loops.size())), numThreads);
 
+    ThreadPool pool(numThreads);
+    OwnedArray<LoopFeatureJob> jobs;
+    Atomic<int> nextLoop;
 
+    for (int t = 0; t < numThreads; ++t)
+        pool.addJob(jobs.add(new LoopFeatureJob(*this, loops, nextLoop)), false);
 
+    for (auto* job : jobs)
+        pool.waitForJobToFinish(job, -1);
+
+    //counted when SHIFTY_COUNT_ALLOCATIONS is on: the per-loop path must leave the heap alone
+    jassert(getLoopAllocations() == 0);
+}
 
+void FeatureExtractor::computeFeaturesForLoop(const lgen::SampleView& loopBuffer, Pool& bin){
+    FeatureGraph& graph = getSerialGraph();
+    graph.compute(loopBuffer, bin);
 
+    const int sampsStart = static_cast<int>(loopBuffer.data() - store->getData());
+    addTimelineFeatures(sampsStart, sampsStart + static_cast<int>(loopBuffer.size()), graph, bin);
+}
+
+//==========================Benchmark===========================================
+void FeatureExtractor::benchmarkFeatureGraph(const std::vector<Loop>& loops, int maxLoops){
+    const int numLoops = jmin(maxLoops, static_cast<int>(loops.size()));
+    if (numLoops == 0) return;
+
+    lgen::SampleView loopBuffer;
+    Pool scratch;
+
+    //before: every loop paid for creating and configuring its own algorithms
+    double start = Time::getMillisecondCounterHiRes();
+    for (int i = 0; i < numLoops; ++i){
+        store->getView(loops[i].sampsStart, loops[i].sampsEnd, loopBuffer);
+        FeatureGraph graph(registry, beatGrid);
+        graph.compute(loopBuffer, scratch);
+    }
+    const double rebuiltSecs = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+    //after: one graph per thread, rebound for every loop
+    FeatureGraph graph(registry, beatGrid);
+    start = Time::getMillisecondCounterHiRes();
+    for (int i = 0; i < numLoops; ++i){
+        store->getView(loops[i].sampsStart, loops[i].sampsEnd, loopBuffer);
+        graph.compute(loopBuffer, scratch);
+    }
+    const double reusedSecs = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+    Logger::writeToLog("FeatureGraph benchmark (" + String(numLoops) + " loops): "
+                       + String(numLoops / rebuiltSecs, 2) + " loops/s rebuilt per loop, "
+                       + String(numLoops / reusedSecs, 2) + " loops/s reused");
+}
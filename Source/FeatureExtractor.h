@@ -17,6 +17,11 @@
 #include "LoopGenerator.h"
 #include "pool.h"
 #include "algorithmfactory.h"
+#include "AllocationCounter.h"
+#include "FeatureGraph.h"
+#include "FeatureTimeline.h"
+#include "BeatGrid.h"
+#include "FeatureRegistry.h"
 
 
 
@@ -26,7 +31,9 @@ using namespace essentia::standard;
 
 class FeatureExtractor {
 public:
-    explicit FeatureExtractor(const VEC_REAL& buffer);
+    /** Only the features required in the registry are extracted; it also
+        collects the time spent in each stage. */
+    FeatureExtractor(const lgen::SampleStore::Ptr& store, FeatureRegistry& registry);
     ~FeatureExtractor();
     
     //allow for alternate delimiters
@@ -36,16 +43,50 @@ public:
    // void findBeats();
     void computeFeaturesForBuffer();
     void computeFeaturesForLoop(Loop& loop);
+    void computeFeaturesForLoop(Loop& loop, FeatureGraph& graph);
+    void computeFeaturesForLoops(std::vector<Loop>& loops,
+                                 int numThreads = SystemStats::getNumCpus());
+    void computeFeaturesForLoop(const lgen::SampleView& loopBuffer, essentia::Pool& bin);
+
+    /** Each thread extracting loop features needs its own graph. Create it
+        after computeFeaturesForBuffer(). */
+    FeatureGraph* createGraph() const { return new FeatureGraph(registry, beatGrid); }
+
+    const FeatureTimeline& getTimeline() const { return timeline; }
+    const BeatGrid&        getBeatGrid() const { return beatGrid; }
+
+    /** Describes a loop from the precomputed timeline alone (no per-loop DSP),
+        e.g. after the file has been re-segmented with a different bar size. */
+    void addTimelineFeatures(Loop& loop);
+
+    /** Heap allocations made while extracting per-loop features, summed over every
+        thread. There should be none; it always reads 0 when SHIFTY_COUNT_ALLOCATIONS is off. */
+    int64 getLoopAllocations() const noexcept { return loopAllocations.get(); }
+
+    /** Logs loops/second with algorithms rebuilt per loop versus one reused graph. */
+    void benchmarkFeatureGraph(const std::vector<Loop>& loops, int maxLoops = 32);
     
     VEC_REAL getOnsets() const { return onsets; }
-    VEC_REAL getBeats()  const { return beats; }
+    VEC_REAL getBeats()  const { return beatGrid.getTicks(); }
     
 private:
 
-    const VEC_REAL AudioBuffer;
-    VEC_REAL onsets, beats;
+    const lgen::SampleStore::Ptr store;
+    FeatureRegistry& registry;
+    const VEC_REAL& AudioBuffer;
+    VEC_REAL onsets;
     const int SR, FrameSize, HopSize;
     bool successfulExtraction;
+    juce::ScopedPointer<FeatureGraph> serialGraph;
+    FeatureTimeline timeline;
+    BeatGrid beatGrid;
+    Atomic<int64> loopAllocations;
+
+    void addTimelineFeatures(int sampsStart, int sampsEnd, FeatureGraph& graph,
+                             essentia::Pool& bin) const;
+    void reserveFeatures(int sampsStart, int sampsEnd, const FeatureGraph& graph,
+                         essentia::Pool& bin) const;
+    FeatureGraph& getSerialGraph();
     
     FeatureExtractor();
     FeatureExtractor(const FeatureExtractor&);
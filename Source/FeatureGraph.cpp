@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    FeatureGraph.cpp
+    Created: 17 Oct 2026 1:47:03pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "FeatureGraph.h"
+
+using namespace essentia;
+using namespace essentia::standard;
+
+//DynamicComplexity's defaults: 200 ms frames at the 44.1 kHz analysis rate, -90 dB floor
+enum { dynamicsFrameSize = 8820 };
+static const Real silenceDb = -90.0f;
+
+static Real getFrameLevel(const VEC_REAL& signal, int frame) noexcept {
+    const int start = frame * dynamicsFrameSize;
+    const int end   = jmin(static_cast<int>(signal.size()), start + dynamicsFrameSize);
+    double sumSq = 0;
+    for (int i = start; i < end; ++i)
+        sumSq += static_cast<double>(signal[i]) * signal[i];
+    return static_cast<Real>(jmax(static_cast<double>(silenceDb), 10.0 * std::log10(sumSq / (end - start) + 1e-30)));
+}
+
+FeatureGraph::FeatureGraph(FeatureRegistry& r, const BeatGrid& b) : registry(r), beatGrid(b)
+{
+    AlgorithmFactory& factory = essentia::standard::AlgorithmFactory::instance();
+
+    /* ========= TONAL FEATURES ===================== */
+    if (registry.needs(FeatureRegistry::Key)){
+        _key = factory.create("Key");
+        _key->output("key")                          .set(key_Key);
+        _key->output("scale")                        .set(key_Scale);
+        _key->output("strength")                     .set(key_Strength);
+        _key->output("firstToSecondRelativeStrength").set(key_FirstToSecond);
+        chroma.reserve(FrameAnalysis::numChromaBins);
+    }
+
+    /* ========= RHYTHM FEATURES ===================== */
+    if (registry.needs(FeatureRegistry::Rhythm))
+        beatGrid.reserve(rhythm);
+}
+
+FeatureGraph::~FeatureGraph(){}
+
+void FeatureGraph::reserve(Pool& bin) const {
+    if (registry.needs(FeatureRegistry::Dynamics)){
+        bin.set("dynam.loud",    Real(0));
+        bin.set("dynam.dyRange", Real(0));
+    }
+    if (registry.needs(FeatureRegistry::Key)){
+        bin.set("tonal.key",    std::string());
+        bin.set("tonal.scale",  std::string());
+        bin.set("tonal.keyStr", Real(0));
+        bin.set("tonal.chroma", VEC_REAL(FrameAnalysis::numChromaBins));
+    }
+}
+
+/*
+    The measure essentia's DynamicComplexity computes, without the buffers it
+    allocates on every call: the level of each frame in dB, leading and
+    trailing silence dropped, then the mean level over the rest (the loudness)
+    and the mean absolute deviation of the frames from it (the complexity).
+    The frame levels are computed twice rather than kept.
+*/
+void FeatureGraph::computeDynamics(const VEC_REAL& signal, Real& loudness, Real& complexity) const noexcept {
+    const int numFrames = (static_cast<int>(signal.size()) + dynamicsFrameSize - 1) / dynamicsFrameSize;
+    int first = -1, last = -1;
+    double sum = 0, sumToLast = 0;
+    for (int f = 0; f < numFrames; ++f){
+        const Real level = getFrameLevel(signal, f);
+        if (level > silenceDb){
+            if (first < 0) first = f;
+            last = f;
+        }
+        if (first >= 0){
+            sum += level;
+            if (last == f) sumToLast = sum;
+        }
+    }
+
+    if (first < 0){
+        loudness   = silenceDb;
+        complexity = 0;
+        return;
+    }
+
+    const int numKept = last - first + 1;
+    loudness = static_cast<Real>(sumToLast / numKept);
+    double deviation = 0;
+    for (int f = first; f <= last; ++f)
+        deviation += std::abs(getFrameLevel(signal, f) - loudness);
+    complexity = static_cast<Real>(deviation / numKept);
+}
+
+void FeatureGraph::compute(const VEC_REAL& loopBuffer, Pool& bin){
+    if (!registry.needs(FeatureRegistry::Dynamics)) return;
+
+    FeatureRegistry::ScopedTimer timer(registry, FeatureRegistry::Dynamics);
+    Real loudness, complexity;
+    computeDynamics(loopBuffer, loudness, complexity);
+
+    bin.set("dynam.loud", loudness);
+    bin.set("dynam.dyRange", complexity);
+}
+
+void FeatureGraph::describeRhythm(_REAL startSecs, _REAL endSecs, Pool& bin){
+    beatGrid.describeRange(startSecs, endSecs, rhythm, bin);
+}
+
+void FeatureGraph::computeKey(const FeatureTimeline& timeline, int sampsStart, int sampsEnd, Pool& bin){
+    jassert(_key != nullptr);
+    timeline.aggregateChroma(sampsStart, sampsEnd, chroma);
+    _key->input("pcp").set(chroma);
+    _key->compute();
+
+    bin.set("tonal.key", key_Key);
+    bin.set("tonal.scale", key_Scale);
+    bin.set("tonal.keyStr", key_Strength);
+    bin.set("tonal.chroma", chroma);
+}
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    FeatureGraph.h
+    Created: 17 Oct 2026 1:47:03pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef FEATUREGRAPH_H_INCLUDED
+#define FEATUREGRAPH_H_INCLUDED
+
+#include "JuceHeader.h"
+#include "essentia.h"
+#include "pool.h"
+#include "algorithmfactory.h"
+#include "SampleStore.h"
+#include "FeatureRegistry.h"
+#include "FeatureTimeline.h"
+#include "BeatGrid.h"
+
+/*
+    The per-loop algorithms and working buffers of one worker thread, created,
+    configured and sized once, so one graph can be reused for every loop the
+    thread processes without touching the heap. A graph is not thread safe:
+    give each thread its own.
+    Spectral and frame-level features are not computed here; they come from the
+    whole-file FrameAnalysis. That includes the HPCP: computeKey() only runs the
+    key estimation on a loop's averaged chroma. Rhythm comes from the BeatGrid.
+    Only the algorithms for stages the registry needs are created.
+*/
+class FeatureGraph {
+public:
+    /** The beat grid must already be computed: the rhythm buffers are sized from it. */
+    FeatureGraph(FeatureRegistry& registry, const BeatGrid& beatGrid);
+    ~FeatureGraph();
+
+    /** Sets dynam.loud and dynam.dyRange from the loop's own samples. */
+    void compute(const VEC_REAL& loopBuffer, essentia::Pool& bin);
+
+    /** Sets tonal.key, tonal.scale, tonal.keyStr and tonal.chroma from the
+        loop's mean HPCP (see FeatureTimeline::aggregateChroma). */
+    void computeKey(const FeatureTimeline& timeline, int sampsStart, int sampsEnd, essentia::Pool& bin);
+
+    /** Sets the rhythm features of the range (see BeatGrid::describeRange). */
+    void describeRhythm(_REAL startSecs, _REAL endSecs, essentia::Pool& bin);
+
+    /** Creates this graph's entries in bin, so computing them later only
+        overwrites values in place. */
+    void reserve(essentia::Pool& bin) const;
+
+private:
+    juce::ScopedPointer<essentia::standard::Algorithm> _key;
+
+    //tonal
+    essentia::Real key_Strength, key_FirstToSecond;
+    std::string    key_Key, key_Scale;
+    VEC_REAL       chroma;
+    //rhythm
+    BeatGrid::Scratch rhythm;
+
+    FeatureRegistry& registry;
+    const BeatGrid& beatGrid;
+
+    void computeDynamics(const VEC_REAL& signal, essentia::Real& loudness,
+                         essentia::Real& complexity) const noexcept;
+
+    FeatureGraph(const FeatureGraph&);
+    FeatureGraph& operator=(const FeatureGraph&);
+};
+
+
+#endif  // FEATUREGRAPH_H_INCLUDED
@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    FeatureMatrix.cpp
+    Created: 17 Oct 2026 9:48:52pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "FeatureMatrix.h"
+
+//same test juce_audio_basics uses for its SSE FloatVectorOperations
+#if JUCE_INTEL && ! (JUCE_MINGW && ! defined (__SSE2__))
+ #define SHIFTY_USE_SSE 1
+ #include <emmintrin.h>
+#else
+ #define SHIFTY_USE_SSE 0
+#endif
+
+namespace mkov{
+
+FeatureMatrix::FeatureMatrix(int loops, int features) :
+    numLoops(loops), numFeatures(features),
+    data(static_cast<size_t>(loops) * features, 0.0f)
+{
+}
+
+FeatureMatrix::FeatureMatrix(const std::vector<Loop>& loops, const char* const* featureNames, int features) :
+    FeatureMatrix(static_cast<int>(loops.size()), features)
+{
+    //the only Pool lookups; the distance loops never see a string again
+    for (int f = 0; f < numFeatures; ++f){
+        const std::string name(featureNames[f]);
+        float* col = data.data() + f * numLoops;
+        for (int i = 0; i < numLoops; ++i)
+            col[i] = loops[i].bin.value<essentia::Real>(name);
+    }
+    normalise();
+}
+
+FeatureMatrix::~FeatureMatrix(){}
+
+void FeatureMatrix::normalise(){
+    if (numLoops == 0) return;
+
+    for (int f = 0; f < numFeatures; ++f){
+        float* col = data.data() + f * numLoops;
+        double sum = 0.0, sumSq = 0.0;
+        for (int i = 0; i < numLoops; ++i){
+            sum   += col[i];
+            sumSq += col[i] * (double) col[i];
+        }
+        const double mean = sum / numLoops;
+        const double sd   = std::sqrt(jmax(0.0, sumSq / numLoops - mean * mean));
+
+        //a constant feature carries no information; it becomes all zeros
+        FloatVectorOperations::add(col, static_cast<float>(-mean), numLoops);
+        if (sd > 0.0)
+            FloatVectorOperations::multiply(col, static_cast<float>(1.0 / sd), numLoops);
+    }
+}
+
+float FeatureMatrix::distance(int i, int j) const noexcept {
+    float dist = 0.0f;
+    for (int f = 0; f < numFeatures; ++f){
+        const float* col = column(f);
+        dist += std::abs(col[i] - col[j]);
+    }
+    return dist;
+}
+
+void FeatureMatrix::distancesFromScalar(int i, int first, int num, float* out) const noexcept {
+    FloatVectorOperations::clear(out, num);
+    for (int f = 0; f < numFeatures; ++f){
+        const float* col = column(f);
+        const float x = col[i];
+        for (int n = 0; n < num; ++n)
+            out[n] += std::abs(col[first + n] - x);
+    }
+}
+
+void FeatureMatrix::distancesFrom(int i, int first, int num, float* out) const noexcept {
+   #if SHIFTY_USE_SSE
+    //clearing the sign bit is |x|
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const int numVec = num & ~3;
+
+    for (int n = 0; n < numVec; n += 4){
+        __m128 acc = _mm_setzero_ps();
+        for (int f = 0; f < numFeatures; ++f){
+            const float* col = column(f);
+            const __m128 diff = _mm_sub_ps(_mm_loadu_ps(col + first + n), _mm_set1_ps(col[i]));
+            acc = _mm_add_ps(acc, _mm_and_ps(diff, absMask));
+        }
+        _mm_storeu_ps(out + n, acc);
+    }
+    if (numVec < num)
+        distancesFromScalar(i, first + numVec, num - numVec, out + numVec);
+   #else
+    distancesFromScalar(i, first, num, out);
+   #endif
+}
+
+void FeatureMatrix::distancesToScalar(int i, const int* candidates, int num, float* out) const noexcept {
+    FloatVectorOperations::clear(out, num);
+    for (int f = 0; f < numFeatures; ++f){
+        const float* col = column(f);
+        const float x = col[i];
+        for (int n = 0; n < num; ++n)
+            out[n] += std::abs(col[candidates[n]] - x);
+    }
+}
+
+void FeatureMatrix::distancesTo(int i, const int* candidates, int num, float* out) const noexcept {
+   #if SHIFTY_USE_SSE
+    //SSE2 has no gather, so four candidates are loaded one by one; the
+    //arithmetic is still four pairs per instruction
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const int numVec = num & ~3;
+
+    for (int n = 0; n < numVec; n += 4){
+        const int* c = candidates + n;
+        __m128 acc = _mm_setzero_ps();
+        for (int f = 0; f < numFeatures; ++f){
+            const float* col = column(f);
+            const __m128 others = _mm_set_ps(col[c[3]], col[c[2]], col[c[1]], col[c[0]]);
+            const __m128 diff = _mm_sub_ps(others, _mm_set1_ps(col[i]));
+            acc = _mm_add_ps(acc, _mm_and_ps(diff, absMask));
+        }
+        _mm_storeu_ps(out + n, acc);
+    }
+    if (numVec < num)
+        distancesToScalar(i, candidates + numVec, num - numVec, out + numVec);
+   #else
+    distancesToScalar(i, candidates, num, out);
+   #endif
+}
+
+//==========================Benchmark===========================================
+//written after each run so the optimiser can't drop the kernels being timed
+static volatile float benchmarkSink;
+
+void FeatureMatrix::benchmark(int numFeatures){
+    const int sizes[] = { 1000, 10000, 50000 };
+    Random random(0x5eed);
+
+    for (int numLoops : sizes){
+        FeatureMatrix matrix(numLoops, numFeatures);
+        for (auto& x : matrix.data)
+            x = random.nextFloat();
+
+        std::vector<float> row(static_cast<size_t>(numLoops));
+        const double numPairs = numLoops * (numLoops - 1.0) / 2.0;
+
+        double start = Time::getMillisecondCounterHiRes();
+        for (int i = 0; i < numLoops - 1; ++i){
+            matrix.distancesFrom(i, i + 1, numLoops - i - 1, row.data());
+            benchmarkSink = row[0];
+        }
+        const double simdSecs = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+        start = Time::getMillisecondCounterHiRes();
+        for (int i = 0; i < numLoops - 1; ++i){
+            matrix.distancesFromScalar(i, i + 1, numLoops - i - 1, row.data());
+            benchmarkSink = row[0];
+        }
+        const double scalarSecs = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+        Logger::writeToLog("FeatureMatrix benchmark (N=" + String(numLoops) + ", F=" + String(numFeatures) + "): "
+                           + String(numPairs / simdSecs / 1.0e6, 1) + " M pairs/s SIMD, "
+                           + String(numPairs / scalarSecs / 1.0e6, 1) + " M pairs/s scalar");
+    }
+}
+
+}
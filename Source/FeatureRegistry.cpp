@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    FeatureRegistry.cpp
+    Created: 17 Oct 2026 7:15:48pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "FeatureRegistry.h"
+#include <cstring>
+
+//Everything the extractor knows how to produce. A new feature goes here first.
+static const FeatureRegistry::Feature knownFeatures[] = {
+    { "dynam.loud",       FeatureRegistry::Dynamics },
+    { "dynam.dyRange",    FeatureRegistry::Dynamics },
+    { "dynam.rms",        FeatureRegistry::FrameTracks },
+    { "dynam.rmsVar",     FeatureRegistry::FrameTracks },
+    { "dynam.energy",     FeatureRegistry::FrameTracks },
+    { "dynam.energyVar",  FeatureRegistry::FrameTracks },
+    { "timbre.cent",      FeatureRegistry::FrameTracks },
+    { "timbre.centVar",   FeatureRegistry::FrameTracks },
+    { "tonal.key",        FeatureRegistry::Key },
+    { "tonal.scale",      FeatureRegistry::Key },
+    { "tonal.keyStr",     FeatureRegistry::Key },
+    { "tonal.chroma",     FeatureRegistry::Key },
+    { "rhythm.bpm",       FeatureRegistry::Rhythm },
+    { "rhythm.beats",     FeatureRegistry::Rhythm },
+    { "rhythm.conf",      FeatureRegistry::Rhythm },
+    { "rhythm.intervals", FeatureRegistry::Rhythm }
+};
+
+FeatureRegistry::FeatureRegistry(){
+    for (int s = 0; s < numStages; ++s)
+        stageNeeded[s] = false;
+}
+
+FeatureRegistry::~FeatureRegistry(){}
+
+const FeatureRegistry::Feature* FeatureRegistry::find(const char* name){
+    for (auto& f : knownFeatures)
+        if (std::strcmp(f.name, name) == 0)
+            return &f;
+    return nullptr;
+}
+
+const char* FeatureRegistry::getStageName(Stage s){
+    static const char* const names[] = { "dynamics", "frame tracks", "key", "rhythm" };
+    return names[s];
+}
+
+void FeatureRegistry::require(const char* name){
+    const Feature* f = find(name);
+    jassert(f != nullptr); //not something the extractor produces
+    if (f == nullptr) return;
+
+    required.addIfNotAlreadyThere(f->name);
+    stageNeeded[f->stage] = true;
+}
+
+void FeatureRegistry::require(const char* const* names, int numNames){
+    for (int i = 0; i < numNames; ++i)
+        require(names[i]);
+}
+
+void FeatureRegistry::requireAll(){
+    for (auto& f : knownFeatures)
+        require(f.name);
+}
+
+bool FeatureRegistry::needs(const char* name) const {
+    return required.contains(name);
+}
+
+double FeatureRegistry::getSeconds(Stage s) const noexcept {
+    return Time::highResolutionTicksToSeconds(stageTicks[s].get());
+}
+
+void FeatureRegistry::logTimings() const {
+    for (int s = 0; s < numStages; ++s){
+        const Stage stage = static_cast<Stage>(s);
+        if (!needs(stage)) continue;
+        Logger::writeToLog("Feature stage " + String(getStageName(stage)) + ": "
+                           + String(getSeconds(stage) * 1000.0, 1) + " ms");
+    }
+    for (auto& name : required){
+        const Feature* f = find(name.toRawUTF8());
+        Logger::writeToLog("  " + name + " <- " + getStageName(f->stage)
+                           + " (" + String(getSeconds(f->stage) * 1000.0, 1) + " ms)");
+    }
+}
@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    FeatureRegistry.h
+    Created: 17 Oct 2026 7:15:48pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef FEATUREREGISTRY_H_INCLUDED
+#define FEATUREREGISTRY_H_INCLUDED
+
+#include "JuceHeader.h"
+
+/*
+    Every per-loop feature the extractor can put in a Loop's Pool, and the
+    analysis stage that produces it. Consumers (the Markov distance, ...)
+    require() the names they read before extraction starts; the extractor then
+    only builds and runs the stages those names depend on.
+    Stages produce several features at once, so time is measured per stage and
+    logTimings() reports each required feature with the cost of its stage.
+*/
+class FeatureRegistry {
+public:
+    enum Stage {
+        Dynamics = 0,   //loudness and dynamic complexity of each loop's samples
+        FrameTracks,    //whole-file STFT descriptors, aggregated per loop
+        Key,            //whole-file HPCP, Key on each loop's mean chroma
+        Rhythm,         //whole-file beat tracking, sliced per loop
+        numStages
+    };
+
+    struct Feature {
+        const char* name;
+        Stage stage;
+    };
+
+    FeatureRegistry();
+    ~FeatureRegistry();
+
+    /** Marks a feature as consumed. Unknown names are a programming error. */
+    void require(const char* name);
+    void require(const char* const* names, int numNames);
+    void requireAll();
+
+    bool needs(Stage s)          const noexcept { return stageNeeded[s]; }
+    bool needs(const char* name) const;
+    const StringArray& getRequired() const noexcept { return required; }
+
+    static const Feature* find(const char* name);
+    static const char* getStageName(Stage s);
+
+    /** Adds the time spent in a stage. Safe to call from worker threads. */
+    void addTime(Stage s, int64 ticks) noexcept { stageTicks[s] += ticks; }
+    double getSeconds(Stage s) const noexcept;
+    void logTimings() const;
+
+    class ScopedTimer {
+    public:
+        ScopedTimer(FeatureRegistry& r, Stage s) noexcept :
+            registry(r), stage(s), start(Time::getHighResolutionTicks()) {}
+        ~ScopedTimer() noexcept { registry.addTime(stage, Time::getHighResolutionTicks() - start); }
+    private:
+        FeatureRegistry& registry;
+        const Stage stage;
+        const int64 start;
+
+        ScopedTimer(const ScopedTimer&);
+        ScopedTimer& operator=(const ScopedTimer&);
+    };
+
+private:
+    StringArray required;
+    bool stageNeeded[numStages];
+    Atomic<int64> stageTicks[numStages];
+
+    FeatureRegistry(const FeatureRegistry&);
+    FeatureRegistry& operator=(const FeatureRegistry&);
+};
+
+
+#endif  // FEATUREREGISTRY_H_INCLUDED
@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    FeatureTimeline.h
+    Created: 17 Oct 2026 4:38:12pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef FEATURETIMELINE_H_INCLUDED
+#define FEATURETIMELINE_H_INCLUDED
+
+#include "JuceHeader.h"
+#include "FrameAnalysis.h"
+
+/*
+    Frame-level feature tracks for a whole file plus integral (prefix-sum)
+    tables of every track and of its square. aggregate() returns the mean and
+    variance of a track over any sample range in constant time, so loops of any
+    length can be re-described without running DSP again.
+*/
+class FeatureTimeline {
+public:
+    struct Stats {
+        _REAL mean, variance;
+    };
+
+    FeatureTimeline(int frameSize, int hopSize);
+    ~FeatureTimeline();
+
+    /** Runs the frame analysis over the signal and builds the prefix tables.
+        The chroma tracks (and aggregateChroma()) are only there withChroma. */
+    void compute(const VEC_REAL& signal, bool withChroma = true);
+
+    Stats aggregate(FrameAnalysis::Track t, int sampsStart, int sampsEnd) const noexcept;
+
+    /** Mean HPCP over [sampsStart, sampsEnd), one value per chroma bin. */
+    void aggregateChroma(int sampsStart, int sampsEnd, VEC_REAL& chroma) const;
+
+    const FrameAnalysis& getFrames() const noexcept { return frames; }
+
+private:
+    FrameAnalysis frames;
+
+    //prefix[t][i] is the sum of the first i frames, so a range costs two lookups
+    std::vector<double> prefix[FrameAnalysis::numTracks];
+    std::vector<double> prefixSq[FrameAnalysis::numTracks];
+
+    void buildPrefixTables();
+
+    FeatureTimeline(const FeatureTimeline&);
+    FeatureTimeline& operator=(const FeatureTimeline&);
+};
+
+
+#endif  // FEATURETIMELINE_H_INCLUDED
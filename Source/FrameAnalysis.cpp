@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    FrameAnalysis.cpp
+    Created: 17 Oct 2026 3:20:51pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "FrameAnalysis.h"
+
+using namespace essentia;
+using namespace essentia::standard;
+
+FrameAnalysis::FrameAnalysis(int frameSize, int hopSize) :
+    FrameSize(frameSize), HopSize(hopSize), numFrames(0)
+{
+}
+
+FrameAnalysis::~FrameAnalysis(){}
+
+void FrameAnalysis::compute(const VEC_REAL& signal, bool withChroma){
+    AlgorithmFactory& factory = essentia::standard::AlgorithmFactory::instance();
+    juce::ScopedPointer<Algorithm>
+            _fc     = factory.create("FrameCutter", "frameSize", FrameSize,
+                                     "hopSize", HopSize),
+            _w      = factory.create("Windowing", "type", "hann"),
+            _spec   = factory.create("Spectrum"),
+            _cent   = factory.create("Centroid"),
+            _rms    = factory.create("RMS"),
+            _energy = factory.create("Energy"),
+            _peaks  = factory.create("SpectralPeaks", "orderBy", "magnitude",
+                                     "magnitudeThreshold", 1e-05,
+                                     "minFrequency", 40, "maxFrequency", 5000,
+                                     "maxPeaks", 100),
+            _hpcp   = factory.create("HPCP", "size", (int)numChromaBins);
+
+    VEC_REAL frame, windowedFrame, spectrum, peakFreqs, peakMags, hpcp;
+    Real centroid, rms, energy;
+
+    _fc    ->input("signal").set(signal);
+    _fc    ->output("frame").set(frame);
+    _w     ->input("frame").set(frame);
+    _w     ->output("frame").set(windowedFrame);
+    _spec  ->input("frame").set(windowedFrame);
+    _spec  ->output("spectrum").set(spectrum);
+    _cent  ->input("array").set(spectrum);
+    _cent  ->output("centroid").set(centroid);
+    _rms   ->input("array").set(frame);
+    _rms   ->output("rms").set(rms);
+    _energy->input("array").set(frame);
+    _energy->output("energy").set(energy);
+    _peaks ->input("spectrum").set(spectrum);
+    _peaks ->output("frequencies").set(peakFreqs);
+    _peaks ->output("magnitudes").set(peakMags);
+    _hpcp  ->input("frequencies").set(peakFreqs);
+    _hpcp  ->input("magnitudes").set(peakMags);
+    _hpcp  ->output("hpcp").set(hpcp);
+
+    const size_t expectedFrames = signal.size() / HopSize + 1;
+    for (int t = 0; t < numTracks; ++t){
+        tracks[t].clear();
+        if (withChroma || t < Chroma)
+            tracks[t].reserve(expectedFrames);
+    }
+
+    while (true){
+        _fc->compute();
+        if (frame.empty()) break;
+
+        _w->compute();
+        _spec->compute();
+        _cent->compute();
+        _rms->compute();
+        _energy->compute();
+
+        tracks[Centroid].push_back(centroid);
+        tracks[RMS]     .push_back(rms);
+        tracks[Energy]  .push_back(energy);
+
+        if (withChroma){
+            _peaks->compute();
+            _hpcp->compute();
+            for (int b = 0; b < numChromaBins; ++b)
+                tracks[Chroma + b].push_back(hpcp[b]);
+        }
+    }
+    numFrames = static_cast<int>(tracks[Centroid].size());
+}
+
+Range<int> FrameAnalysis::getFrameRange(int sampsStart, int sampsEnd) const noexcept {
+    if (numFrames == 0)
+        return Range<int>();
+
+    const int first = jmin((sampsStart + HopSize - 1) / HopSize, numFrames - 1);
+    const int last  = jmin((sampsEnd - 1) / HopSize, numFrames - 1);
+
+    if (last < first){
+        const int nearest = jmin((sampsStart + HopSize / 2) / HopSize, numFrames - 1);
+        return Range<int>(nearest, nearest + 1);
+    }
+    return Range<int>(first, last + 1);
+}
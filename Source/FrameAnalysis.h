@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    FrameAnalysis.h
+    Created: 17 Oct 2026 3:20:51pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef FRAMEANALYSIS_H_INCLUDED
+#define FRAMEANALYSIS_H_INCLUDED
+
+#include "JuceHeader.h"
+#include "essentia.h"
+#include "algorithmfactory.h"
+#include "SampleStore.h"
+
+/*
+    Hop-aligned STFT of a whole file, computed once and shared by every loop.
+    Frame i is centred on sample i * hopSize (FrameCutter's default). Each
+    spectrum is reduced to per-frame descriptor tracks as soon as it is
+    computed; the spectra themselves are not kept, since an hour-long file
+    would need several hundred MB for them. A new spectral descriptor (MFCC,
+    ...) becomes a new Track. The 12-bin HPCP (chroma) takes one track per bin,
+    starting at Chroma.
+*/
+class FrameAnalysis {
+public:
+    enum { numChromaBins = 12 };
+
+    enum Track {
+        Centroid = 0,
+        RMS,
+        Energy,
+        Chroma,
+        numTracks = Chroma + numChromaBins
+    };
+
+    FrameAnalysis(int frameSize, int hopSize);
+    ~FrameAnalysis();
+
+    /** Without chroma the HPCP tracks are left empty. */
+    void compute(const VEC_REAL& signal, bool withChroma = true);
+
+    int getNumFrames() const noexcept { return numFrames; }
+    int getHopSize()   const noexcept { return HopSize; }
+    const VEC_REAL& getTrack(Track t) const noexcept { return tracks[t]; }
+    bool hasTrack(Track t)            const noexcept { return (int) tracks[t].size() == numFrames; }
+
+    static Track chromaTrack(int bin) noexcept { return static_cast<Track>(Chroma + bin); }
+
+    /** Frames whose centres fall inside [sampsStart, sampsEnd). A range shorter
+        than a hop still gets the frame nearest to its start. */
+    Range<int> getFrameRange(int sampsStart, int sampsEnd) const noexcept;
+
+private:
+    const int FrameSize, HopSize;
+    int numFrames;
+    VEC_REAL tracks[numTracks];
+
+    FrameAnalysis(const FrameAnalysis&);
+    FrameAnalysis& operator=(const FrameAnalysis&);
+};
+
+
+#endif  // FRAMEANALYSIS_H_INCLUDED
@@ -8,12 +8,13 @@
 
 #include "LoopGenerator.h"
 #include "FeatureExtractor.h"
+#include "MarkovChain.h"
 
 
 namespace lgen{
 
-LoopGenerator::LoopGenerator(const VEC_REAL& _AudioBuffer, const VEC_REAL& _delim) :
-    BarSize(1.0), AudioBuffer(_AudioBuffer), delimiters(_delim)
+LoopGenerator::LoopGenerator(const SampleStore::Ptr& _store, const VEC_REAL& _delim, float barSize) :
+    BarSize(barSize), store(_store), AudioBuffer(_store->samples()), delimiters(_delim)
 {
     lastDelimiter = delimiters.back();
 }
@@ -79,40 +80,39 @@ _REAL LoopGenerator::quantizeToDelimiter(_REAL value){
     _REAL bpm;
     
 //==========================Buffer Audio========================================
-    VEC_REAL initAudio(const std::string audiofilename){
-        essentia::init();
-        juce::ScopedPointer<essentia::standard::Algorithm>
-            loader = essentia::standard::AlgorithmFactory::create("MonoLoader",
-                                                                  "filename", audiofilename,
-                                                                  "sampleRate", 44100);
-        VEC_REAL buffer;
-        loader->output("audio").set(buffer);
-        loader->compute();
-        lgen::audioBuffered = true;
-        essentia::shutdown();
+    SampleStore::Ptr initAudio(const AudioAsset& asset){
+        SampleStore::Ptr store = asset.createSampleStore(44100.0);
+        lgen::audioBuffered = (store != nullptr);
         
-        return buffer;
+        return store;
        
     }
     
 //==========================Compute Loops=======================================
-    std::vector<Loop> constructLoops(const VEC_REAL& buffer){
+    std::vector<Loop> constructLoops(const SampleStore::Ptr& store){
 
-        if (lgen::audioBuffered){
-            FeatureExtractor xtractor(buffer);
+        if (lgen::audioBuffered && store != nullptr){
+            //only what the consumers below read gets extracted
+            FeatureRegistry registry;
+            mkov::MarkovChain::requireFeatures(registry);
+            FeatureExtractor xtractor(store, registry);
             //Can use either onsets or beats as loop points
             //xtractor.findOnsets();
             //xtractor.findBeats();
             xtractor.computeFeaturesForBuffer();
             //LoopGenerator loopGen(buffer, xtractor.getBeats());
-            LoopGenerator loopGen(buffer, xtractor.getOnsets());
+            LoopGenerator loopGen(store, xtractor.getOnsets());
             loopGen.createLoopPoints();
             loopGen.connectLoops();
             
-            for (auto& lp : loopGen.getLoops())
-                xtractor.computeFeaturesForLoop(lp);
+            std::vector<Loop> loops(loopGen.getLoops());
+            xtractor.computeFeaturesForLoops(loops);
+           #if SHIFTY_RUN_BENCHMARKS
+            registry.logTimings();
+            xtractor.benchmarkFeatureGraph(loops);
+           #endif
 
-            return loopGen.getLoops();
+            return loops;
         } else {
             AlertWindow::showMessageBoxAsync(AlertWindow::WarningIcon,"Audio File",
                                              "Unable to buffer audiofile");
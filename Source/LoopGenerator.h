@@ -17,9 +17,8 @@
 #include "essentia.h"
 #include "algorithmfactory.h"
 #include "ProgressWindow.h"
-
-typedef essentia::Real _REAL;
-typedef std::vector<essentia::Real> VEC_REAL;
+#include "SampleStore.h"
+#include "AudioAsset.h"
 
 struct Loop {
 
@@ -36,15 +35,15 @@ namespace lgen{
 
 class LoopGenerator {
 public:
-    LoopGenerator(const VEC_REAL& _AudioBuffer, const VEC_REAL& _delim);
+    LoopGenerator(const SampleStore::Ptr& _store, const VEC_REAL& _delim, float barSize = 1.0f);
     ~LoopGenerator();
     
     void createLoopPoints();
     void connectLoops();
     _REAL quantizeToDelimiter(_REAL value);
     
-    VEC_REAL           getBuffer() const { return AudioBuffer; }
-    std::vector<Loop>  getLoops()  const { return _Loops; }
+    const VEC_REAL&          getBuffer() const { return AudioBuffer; }
+    const std::vector<Loop>& getLoops()  const { return _Loops; }
     _REAL getNumLoopsToCreate()    const { return delimiters.size(); }
     
     void setLastDelimiter(VEC_REAL& dv){ lastDelimiter = dv.back(); }
@@ -53,7 +52,8 @@ private:
     const int SR = 44100;
     const float BarSize;
     float lastDelimiter;
-    const VEC_REAL AudioBuffer;
+    const SampleStore::Ptr store;
+    const VEC_REAL& AudioBuffer;
     VEC_REAL       delimiters;
     std::vector<Loop> _Loops;
     
@@ -65,8 +65,8 @@ private:
     
 //namespace (non-member) helper functions
     
-    VEC_REAL initAudio(const std::string audiofilename);
-    std::vector<Loop> constructLoops(const VEC_REAL& buffer);
+    SampleStore::Ptr initAudio(const AudioAsset& asset);
+    std::vector<Loop> constructLoops(const SampleStore::Ptr& store);
     
 }
 
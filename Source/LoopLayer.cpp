@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    LoopLayer.cpp
+    Created: 18 Oct 2026 10:17:08pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "LoopLayer.h"
+
+//a high centroid is mostly percussive, a low one mostly bass
+const LayerFilter LoopLayer::defaultFilters[] = {
+    { "Bass",    "timbre.cent", 0.0f,   0.333f, 0.8f },
+    { "Texture", "timbre.cent", 0.333f, 0.666f, 0.5f },
+    { "Drums",   "timbre.cent", 0.666f, 1.0f,   0.7f }
+};
+const int LoopLayer::numDefaultFilters = numElementsInArray(LoopLayer::defaultFilters);
+
+LoopLayer::LoopLayer(const std::vector<Loop>& allLoops, const LayerFilter& filter,
+                     const BoundaryCache& allBoundaries, const lgen::AudioAsset::Ptr& asset, Random& random) :
+    name(filter.name), gain(filter.gain), startLoop(0)
+{
+    if (allLoops.empty()) return;
+
+    const std::string feature(filter.feature);
+    std::vector<float> values;
+    values.reserve(allLoops.size());
+    for (auto& loop : allLoops)
+        values.push_back(loop.bin.value<essentia::Real>(feature));
+
+    std::vector<float> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+    const int last = static_cast<int>(sorted.size()) - 1;
+    const float low  = sorted[jlimit(0, last, roundToInt(filter.lowQuantile * last))];
+    const float high = sorted[jlimit(0, last, roundToInt(filter.highQuantile * last))];
+
+    std::vector<int> loopIds;
+    for (size_t i = 0; i < allLoops.size(); ++i){
+        //the top quantile keeps its maximum, the others leave it to the next layer
+        if (values[i] >= low && (values[i] < high || filter.highQuantile >= 1.0f)){
+            loops.push_back(allLoops[i]);
+            loopIds.push_back(static_cast<int>(i));
+        }
+    }
+    if (loops.empty()) return;
+
+    model = new mkov::MarkovChain(loops);
+    model->computeDistances();
+    boundaries = new BoundaryCache(allBoundaries, loopIds);
+    model->blendSpliceCosts(*boundaries);
+    planner = new SplicePlanner(asset, loops, model->getTransitionGraph(), *boundaries);
+
+    startLoop = random.nextInt(static_cast<int>(loops.size()));
+    generator = new mkov::MarkovGenerator(model->getAliasTable(), startLoop);
+
+    Logger::writeToLog("Layer " + name + ": " + String((int) loops.size()) + " of "
+                       + String((int) allLoops.size()) + " loops");
+}
+
+LoopLayer::~LoopLayer(){
+    //the generator and planner threads read the model; stop them first
+    generator = nullptr;
+    planner = nullptr;
+}
@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    LoopLayer.h
+    Created: 18 Oct 2026 10:17:08pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef LOOPLAYER_H_INCLUDED
+#define LOOPLAYER_H_INCLUDED
+
+#include <vector>
+#include <algorithm>
+#include "JuceHeader.h"
+#include "LoopGenerator.h"
+#include "MarkovChain.h"
+#include "SplicePlanner.h"
+
+/** Picks the loops of one layer: those whose feature lies between two
+    quantiles of its distribution over all loops, e.g. the darkest third. */
+struct LayerFilter {
+    const char* name;
+    const char* feature;
+    float lowQuantile, highQuantile;
+    float gain;
+};
+
+/*
+    One independent walk for layered shifty looping: the loops passing a
+    LayerFilter, with their own transition graph, splice plans and endless
+    generator, built exactly like the main walk but over the subset. The
+    boundary analysis is the main walk's, looked up by the loops' original
+    indices. Hand it to ShiftyLooper::addLayer(); it must outlive the layer.
+*/
+class LoopLayer {
+public:
+    /** Bass, texture and drums, split by spectral centroid. */
+    static const LayerFilter defaultFilters[];
+    static const int numDefaultFilters;
+
+    /** allBoundaries covers allLoops; the layer keeps the part it needs. */
+    LoopLayer(const std::vector<Loop>& allLoops, const LayerFilter& filter,
+              const BoundaryCache& allBoundaries, const lgen::AudioAsset::Ptr& asset, Random& random);
+    ~LoopLayer();
+
+    const String& getName() const noexcept          { return name; }
+    float getGain() const noexcept                  { return gain; }
+    bool  isEmpty() const noexcept                  { return loops.empty(); }
+    const std::vector<Loop>& getLoops() const noexcept { return loops; }
+    /** Only valid when !isEmpty(). */
+    mkov::MarkovGenerator& getGenerator() const noexcept { return *generator; }
+    const SplicePlanner* getSplicePlanner() const noexcept { return planner; }
+    int getStartLoop() const noexcept               { return startLoop; }
+
+private:
+    const String name;
+    const float gain;
+    std::vector<Loop> loops;
+    ScopedPointer<mkov::MarkovChain> model;
+    ScopedPointer<BoundaryCache> boundaries;
+    ScopedPointer<SplicePlanner> planner;
+    ScopedPointer<mkov::MarkovGenerator> generator;
+    int startLoop;
+
+    LoopLayer(const LoopLayer&);
+    LoopLayer& operator=(const LoopLayer&);
+};
+
+
+#endif  // LOOPLAYER_H_INCLUDED
@@ -0,0 +1,303 @@
+/*
+  ==============================================================================
+
+    LoopSamplerSource.cpp
+    Created: 18 Oct 2026 6:12:54pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "LoopSamplerSource.h"
+
+//samples in all the tables of one direction: shortestFade * (2^numFadeLengths - 1)
+static const int totalFadeSamples = LoopSamplerSource::shortestFade * ((1 << LoopSamplerSource::numFadeLengths) - 1);
+
+LoopSamplerSource::LoopSamplerSource(int maxVoices) :
+    numVoices(jmax(1, maxVoices)), voices(static_cast<size_t>(jmax(1, maxVoices)), true),
+    outputRate(44100.0), ratio(1.0), fades(static_cast<size_t>(2 * totalFadeSamples)), scratchSize(0)
+{
+    for (int n = 0; n < numVoices * maxResampledChannels; ++n)
+        interpolators.add(new LagrangeInterpolator());
+
+    //equal power: in^2 + out^2 = 1 at every sample of the crossfade
+    for (int k = 1; k <= numFadeLengths; ++k){
+        const int length = getFadeLength(k);
+        float* in  = const_cast<float*>(getFadeIn(k));
+        float* out = const_cast<float*>(getFadeOut(k));
+        for (int n = 0; n < length; ++n){
+            const double phase = (n + 0.5) / length * double_Pi * 0.5;
+            in[n]  = static_cast<float>(std::sin(phase));
+            out[n] = static_cast<float>(std::cos(phase));
+        }
+    }
+    prepareToPlay(512, 44100.0);
+}
+
+const float* LoopSamplerSource::getFadeIn(int fadeIndex) const noexcept {
+    return fades + shortestFade * ((1 << (fadeIndex - 1)) - 1);
+}
+
+const float* LoopSamplerSource::getFadeOut(int fadeIndex) const noexcept {
+    return getFadeIn(fadeIndex) + totalFadeSamples;
+}
+
+LoopSamplerSource::~LoopSamplerSource(){}
+
+void LoopSamplerSource::setAsset(const lgen::AudioAsset::Ptr& newAsset){
+    stopAllVoices();
+    asset = newAsset;
+    updateRatio();
+    allocateSourceBlock();
+}
+
+void LoopSamplerSource::updateRatio() noexcept {
+    const double newRatio = asset != nullptr ? asset->getSampleRate() / outputRate : 1.0;
+    if (newRatio != ratio){
+        stopAllVoices();
+        ratio = newRatio;
+    }
+}
+
+void LoopSamplerSource::allocateSourceBlock(){
+    if (asset == nullptr || asset->getDecodedBuffer() != nullptr){
+        sourceBlock.setSize(1, 1);
+        return;
+    }
+    //a whole scratch block of output plus the two extra samples an interpolator may take
+    const int length = static_cast<int>(std::ceil(scratchSize * jmax(1.0, ratio))) + 2;
+    sourceBlock.setSize(asset->getNumChannels(), length);
+}
+
+int LoopSamplerSource::getOutputLength(int numSourceSamples) const noexcept {
+    return ratio == 1.0 ? numSourceSamples : static_cast<int>(std::ceil(numSourceSamples / ratio));
+}
+
+int LoopSamplerSource::getOutputSamplesLeft(const Voice& voice) const noexcept {
+    const int sourceLeft = asset->getNumSamples() - voice.position;
+    //the interpolator may take one input sample beyond ratio per output sample
+    return ratio == 1.0 ? sourceLeft : jmax(0, static_cast<int>((sourceLeft - 1) / ratio));
+}
+
+int LoopSamplerSource::startVoice(int firstSample, int numSamples, float gain, int fadeIndex) noexcept {
+    return startVoice(Range<int>(0, numVoices), firstSample, numSamples, gain, fadeIndex);
+}
+
+int LoopSamplerSource::startVoice(Range<int> range, int firstSample, int numSamples, float gain, int fadeIndex) noexcept {
+    range = range.getIntersectionWith(Range<int>(0, numVoices));
+    if (asset == nullptr || range.isEmpty())
+        return -1;
+
+    int voice = range.getStart();
+    for (int v = range.getStart(); v < range.getEnd(); ++v){
+        if (voices[v].remaining <= 0){ voice = v; break; }
+        if (voices[v].remaining < voices[voice].remaining) voice = v;
+    }
+
+    const int first = jlimit(0, asset->getNumSamples(), firstSample);
+    Voice& v = voices[voice];
+    v.position = first;
+    v.start    = first;
+    v.played   = 0;
+    if (ratio != 1.0){
+        //feed the interpolators up to two samples past the entry: the first output is then the entry
+        //itself when upsampling, and within one source sample of it when downsampling
+        const int primeStart = jmax(0, first - 2);
+        v.position = jmin(asset->getNumSamples(), first + 2);
+        float prime[maxResampledChannels][4];
+        float* primeChannels[maxResampledChannels];
+        for (int c = 0; c < maxResampledChannels; ++c)
+            primeChannels[c] = prime[c];
+        asset->read(primeChannels, maxResampledChannels, 0, primeStart, v.position - primeStart);
+
+        for (int c = 0; c < maxResampledChannels; ++c){
+            LagrangeInterpolator& interpolator = *interpolators.getUnchecked(voice * maxResampledChannels + c);
+            interpolator.reset();
+            if (c >= asset->getNumChannels()) continue;
+
+            //one at a time: the unity-ratio shortcut only keeps the history in order below four samples
+            float discard;
+            for (int n = 0; n < v.position - primeStart; ++n)
+                interpolator.process(1.0, prime[c] + n, &discard, 1);
+        }
+    }
+    v.remaining = jlimit(0, getOutputSamplesLeft(v), getOutputLength(numSamples));
+    v.gain      = gain;
+    v.ramp      = nullptr;
+    v.rampRemaining = 0;
+    if (fadeIndex > 0){
+        v.ramp = getFadeIn(fadeIndex);
+        v.rampRemaining = jmin(getFadeLength(fadeIndex), v.remaining);
+    }
+    return voice;
+}
+
+void LoopSamplerSource::releaseVoice(int voice, int fadeIndex) noexcept {
+    Voice& v = voices[voice];
+    if (fadeIndex <= 0 || asset == nullptr){
+        v.remaining = 0;
+        return;
+    }
+    //whatever follows the voice's segment in the file is what fades away
+    v.remaining     = jmin(getFadeLength(fadeIndex), getOutputSamplesLeft(v));
+    v.ramp          = getFadeOut(fadeIndex);
+    v.rampRemaining = v.remaining;
+}
+
+void LoopSamplerSource::stopAllVoices() noexcept {
+    for (int v = 0; v < numVoices; ++v)
+        voices[v].remaining = 0;
+}
+
+int LoopSamplerSource::getNumActiveVoices() const noexcept {
+    int active = 0;
+    for (int v = 0; v < numVoices; ++v)
+        active += isVoiceActive(v) ? 1 : 0;
+    return active;
+}
+
+void LoopSamplerSource::renderVoices(AudioSampleBuffer& buffer, int startSample, int numSamples) noexcept {
+    if (asset == nullptr)
+        return;
+
+    for (int v = 0; v < numVoices; ++v){
+        Voice& voice = voices[v];
+        const int num = jmin(numSamples, voice.remaining);
+        if (num <= 0) continue;
+
+        int offset = 0;
+        if (voice.ramp != nullptr){
+            offset = jmin(num, voice.rampRemaining);
+            renderVoice(v, buffer, startSample, offset);
+        }
+        if (num > offset)
+            renderVoice(v, buffer, startSample + offset, num - offset);
+    }
+}
+
+void LoopSamplerSource::renderVoice(int v, AudioSampleBuffer& buffer, int startSample, int numSamples) noexcept {
+    Voice& voice = voices[v];
+    const AudioSampleBuffer* decoded = asset->getDecodedBuffer();
+    const int numSourceChannels = asset->getNumChannels();
+    const int numChannels = buffer.getNumChannels();
+    const int numRead = jmin(numSourceChannels, numChannels, ratio == 1.0 ? numSourceChannels : (int) maxResampledChannels);
+
+    for (int done = 0; done < numSamples;){
+        const int num = jmin(numSamples - done, scratchSize);
+        if (voice.ramp != nullptr)
+            FloatVectorOperations::multiply(rampScratch, voice.ramp, voice.gain, num);
+
+        if (decoded == nullptr){
+            const int numIn = ratio == 1.0 ? num : jmin(sourceBlock.getNumSamples(), static_cast<int>(num * ratio) + 2);
+            asset->read(sourceBlock.getArrayOfWritePointers(), numRead, 0, voice.position, numIn);
+        }
+
+        int consumed = num;
+        for (int s = 0; s < numRead; ++s){
+            const float* in = decoded != nullptr ? decoded->getReadPointer(s, voice.position) : sourceBlock.getReadPointer(s);
+            if (ratio != 1.0){
+                consumed = interpolators.getUnchecked(v * maxResampledChannels + s)->process(ratio, in, resampled, num);
+                in = resampled;
+            }
+            if (voice.ramp != nullptr){
+                FloatVectorOperations::multiply(scratch, in, rampScratch, num);
+                in = scratch;
+            }
+            //mono files feed every output channel
+            for (int c = s; c < numChannels; c += numSourceChannels){
+                if (voice.ramp != nullptr)
+                    FloatVectorOperations::add(buffer.getWritePointer(c, startSample + done), in, num);
+                else
+                    FloatVectorOperations::addWithMultiply(buffer.getWritePointer(c, startSample + done), in, voice.gain, num);
+            }
+        }
+        if (voice.ramp != nullptr){
+            voice.ramp          += num;
+            voice.rampRemaining -= num;
+        }
+        voice.position  += consumed;
+        voice.remaining -= num;
+        voice.played    += num;
+        done += num;
+    }
+    if (voice.ramp != nullptr && voice.rampRemaining <= 0)
+        voice.ramp = nullptr;
+}
+
+void LoopSamplerSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate){
+    if (samplesPerBlockExpected > scratchSize){
+        scratchSize = samplesPerBlockExpected;
+        scratch.allocate(static_cast<size_t>(scratchSize), false);
+        rampScratch.allocate(static_cast<size_t>(scratchSize), false);
+        resampled.allocate(static_cast<size_t>(scratchSize), false);
+    }
+    if (sampleRate > 0.0){
+        outputRate = sampleRate;
+        updateRatio();
+    }
+    allocateSourceBlock();
+}
+
+void LoopSamplerSource::releaseResources(){}
+
+void LoopSamplerSource::getNextAudioBlock(const AudioSourceChannelInfo& info){
+    info.clearActiveBufferRegion();
+    renderVoices(*info.buffer, info.startSample, info.numSamples);
+}
+
+//==============================================================================
+//mean time to render one block with count voices always playing
+static double timeBlock(const lgen::AudioAsset::Ptr& asset, int count, int blockSize, Random& random){
+    //fewer, longer blocks as the count grows keep every step to a fraction of a second
+    const int numBlocks = jlimit(50, 2000, (1 << 16) / count);
+    const int length = asset->getNumSamples();
+    AudioSampleBuffer buffer(2, blockSize);
+
+    LoopSamplerSource sampler(count);
+    sampler.setAsset(asset);
+    sampler.prepareToPlay(blockSize, asset->getSampleRate());
+
+    double renderMs = 0.0;
+    for (int b = 0; b < numBlocks; ++b){
+        //voices that ran off the end come back somewhere else, fading in
+        while (sampler.getNumActiveVoices() < count)
+            sampler.startVoice(random.nextInt(length), length, 1.0f / count, b == 0 ? 0 : 3);
+
+        buffer.clear();
+        const double start = Time::getMillisecondCounterHiRes();
+        sampler.renderVoices(buffer, 0, blockSize);
+        renderMs += Time::getMillisecondCounterHiRes() - start;
+    }
+    return renderMs / numBlocks;
+}
+
+void LoopSamplerSource::benchmark(const lgen::AudioAsset::Ptr& asset, int blockSize, int maxVoices){
+    if (asset == nullptr || asset->getNumSamples() <= blockSize) return;
+
+    const double budgetMs = 1000.0 * blockSize / asset->getSampleRate();
+    Random random(1);
+
+    //doubling brackets the limit: fits is the largest count measured within budget,
+    //over the smallest one measured past it (0 while none has been)
+    int fits = 0, over = 0;
+    for (int count = 1; over == 0 && fits < maxVoices; count = jmin(count * 2, maxVoices)){
+        const double blockMs = timeBlock(asset, count, blockSize, random);
+        Logger::writeToLog("LoopSamplerSource benchmark: " + String(count) + " voices, "
+                           + String(blockMs * 1000.0, 2) + " us per " + String(blockSize) + "-sample block ("
+                           + String(100.0 * blockMs / budgetMs, 1) + "% of budget)");
+        (blockMs < budgetMs ? fits : over) = count;
+    }
+
+    //then bisection narrows it down to the exact count
+    while (over - fits > 1){
+        const int count = fits + (over - fits) / 2;
+        (timeBlock(asset, count, blockSize, random) < budgetMs ? fits : over) = count;
+    }
+
+    if (over == 0)
+        Logger::writeToLog("LoopSamplerSource benchmark: all " + String(maxVoices) + " voices fit in a "
+                           + String(blockSize) + "-sample block on one core; raise maxVoices to find the limit");
+    else
+        Logger::writeToLog("LoopSamplerSource benchmark: " + String(fits) + " voices fit in a "
+                           + String(blockSize) + "-sample block on one core, " + String(over) + " do not");
+}
@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    LoopSamplerSource.h
+    Created: 18 Oct 2026 6:12:54pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef LOOPSAMPLERSOURCE_H_INCLUDED
+#define LOOPSAMPLERSOURCE_H_INCLUDED
+
+#include "JuceHeader.h"
+#include "AudioAsset.h"
+
+/*
+    Plays segments of an AudioAsset straight from memory. A voice is just a
+    read position, an end and a gain, so starting one anywhere in the file is
+    a constant-time seek: no reader, no buffering thread. Decoded assets are
+    read in place; a memory-mapped WAV is converted a block at a time into
+    scratch space as the voice reaches it.
+    All voices are allocated up front; getNextAudioBlock() and renderVoices()
+    never allocate or lock. Voices are meant to be started and stopped from
+    the render thread (e.g. by a scheduler splitting its block at a loop
+    boundary); setAsset() must not run while rendering.
+
+    A voice can fade in when it starts and fade out when it is released.
+    The equal-power ramps come from tables built in the constructor, one per
+    fade length (shortestFade doubled up to numFadeLengths times), and are
+    applied with FloatVectorOperations, so a crossfade costs two multiplies
+    per sample.
+
+    Positions and lengths passed in are asset samples; everything that is
+    rendered (remaining samples, fades) is counted in output samples at the
+    rate given to prepareToPlay(). When the two rates differ each voice
+    resamples through its own LagrangeInterpolators, which lag their input by
+    two samples, so a voice starts reading two samples before its entry.
+    Resampled voices play at most maxResampledChannels source channels.
+*/
+class LoopSamplerSource : public AudioSource {
+public:
+    enum { defaultNumVoices = 8, shortestFade = 64, numFadeLengths = 6, maxResampledChannels = 2 };
+
+    /** 0 for no fade, otherwise shortestFade << (fadeIndex - 1). */
+    static int getFadeLength(int fadeIndex) noexcept { return fadeIndex > 0 ? (int) shortestFade << (fadeIndex - 1) : 0; }
+
+    explicit LoopSamplerSource(int maxVoices = defaultNumVoices);
+    ~LoopSamplerSource();
+
+    /** Stops every voice. */
+    void setAsset(const lgen::AudioAsset::Ptr& newAsset);
+    const lgen::AudioAsset* getAsset() const noexcept { return asset; }
+
+    /** Plays numSamples from firstSample at gain, clipped to the asset. Returns
+        the voice, stealing the one nearest its end if all are busy. */
+    int  startVoice(int firstSample, int numSamples, float gain = 1.0f, int fadeIndex = 0) noexcept;
+    /** The same, but only ever using (or stealing) voices in range, so several
+        players can share the sampler without cutting each other off. */
+    int  startVoice(Range<int> range, int firstSample, int numSamples, float gain = 1.0f, int fadeIndex = 0) noexcept;
+    /** How many output samples a voice takes to play numSourceSamples. */
+    int  getOutputLength(int numSourceSamples) const noexcept;
+    /** The asset sample the voice's next output sample comes from, counted from
+        what it has actually rendered since it started. */
+    double getSourcePosition(int voice) const noexcept { return voices[voice].start + voices[voice].played * ratio; }
+    /** Lets a voice (even one that has just reached its end) play on from
+        where it is for the fade's length, fading out; or stops it at once. */
+    void releaseVoice(int voice, int fadeIndex) noexcept;
+    void stopVoice(int voice) noexcept              { voices[voice].remaining = 0; }
+    void stopAllVoices() noexcept;
+    bool isVoiceActive(int voice) const noexcept    { return voices[voice].remaining > 0; }
+    int  getNumActiveVoices() const noexcept;
+    int  getMaxVoices() const noexcept              { return numVoices; }
+
+    /** Adds numSamples of every active voice into buffer from startSample. */
+    void renderVoices(AudioSampleBuffer& buffer, int startSample, int numSamples) noexcept;
+
+    /** Allocates the scratch space for ramped and resampled voices and sets the
+        output rate; a change of rate stops every voice. */
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock(const AudioSourceChannelInfo& info) override;
+
+    /** Renders stereo blocks of blockSize samples from asset with 1, 2, 4 ... voices
+        until one block's real-time budget on this thread is exceeded, then bisects
+        and logs exactly how many voices fit. */
+    static void benchmark(const lgen::AudioAsset::Ptr& asset, int blockSize = 128, int maxVoices = 1 << 16);
+
+private:
+    struct Voice {
+        int   position, remaining;  //next asset sample read, output samples left
+        float gain;
+        const float* ramp;          //the rest of its fade, or nullptr
+        int   rampRemaining;
+        int   start, played;        //entry, output samples rendered since
+    };
+
+    const int numVoices;
+    HeapBlock<Voice> voices;
+    OwnedArray<LagrangeInterpolator> interpolators;  //maxResampledChannels per voice
+    lgen::AudioAsset::Ptr asset;
+    double outputRate, ratio;       //asset samples per output sample
+
+    //every fade-in table, then every fade-out table, shortest first
+    HeapBlock<float> fades;
+    HeapBlock<float> scratch, rampScratch, resampled;
+    int scratchSize;
+    AudioSampleBuffer sourceBlock;  //a voice's input for one scratch block, for mapped assets
+
+    const float* getFadeIn(int fadeIndex) const noexcept;
+    const float* getFadeOut(int fadeIndex) const noexcept;
+    void updateRatio() noexcept;
+    void allocateSourceBlock();
+    int  getOutputSamplesLeft(const Voice& voice) const noexcept;
+    void renderVoice(int v, AudioSampleBuffer& buffer, int startSample, int numSamples) noexcept;
+
+    LoopSamplerSource(const LoopSamplerSource&);
+    LoopSamplerSource& operator=(const LoopSamplerSource&);
+};
+
+
+#endif  // LOOPSAMPLERSOURCE_H_INCLUDED
@@ -21,6 +21,19 @@ public:
 
   
     void initialise (const String& commandLine) override{
+       #if JUCE_UNIT_TESTS
+        //"--unit-tests" runs every UnitTest linked into the app, then quits
+        if (commandLine.contains("--unit-tests")){
+            UnitTestRunner runner;
+            runner.runAllTests();
+            int failures = 0;
+            for (int i = 0; i < runner.getNumResults(); ++i)
+                failures += runner.getResult(i)->failures;
+            setApplicationReturnValue(failures > 0 ? 1 : 0);
+            quit();
+            return;
+        }
+       #endif
 //        ScopedPointer<SplashScreen> splash = new SplashScreen("ShiftyLooping",
 //                                                              ImageCache::getFromMemory(
 //                                                                AudioApp::slsplash_png,
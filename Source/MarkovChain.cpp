@@ -15,92 +15,148 @@ namespace mkov{
 //These are currently the features being used to calculate similarity
 const char* features[] = {"dynam.rms", "timbre.cent", "tonal.keyStr", "dynam.dyRange"};
 
-MarkovChain::MarkovChain(const std::vector<Loop>& _loops, MATRIX& inMat, int r, int c) :
-    rows(r), cols(c), _Loops(_loops),inputMatrix(inMat)
+MarkovChain::MarkovChain(const std::vector<Loop>& _loops) : _Loops(_loops)
 {
-    initMatrix();
 }
 
 MarkovChain::~MarkovChain(){}
 
-inline int MarkovChain::overlapExists(const Loop& a, const Loop& b){
-    if (a.start < b.end || a.end > b.start) {
-        return false;
+void MarkovChain::requireFeatures(FeatureRegistry& registry){
+    registry.require(features, numElementsInArray(features));
+}
+
+void MarkovChain::computeDistances(int maxNeighbours, CandidateMode mode){
+    const FeatureMatrix matrix(_Loops, features, numFeatures);
+
+    if (mode == overlappingLoops){
+        computeOverlapDistances(matrix, maxNeighbours);
     } else {
-        return true;
+        //tiled over the upper triangle on all cores; only the k best of each row are kept
+        SimilarityBuilder builder(matrix, maxNeighbours);
+        builder.build(transitions);
     }
+    aliases = new AliasTable(transitions);
+
+   #if SHIFTY_RUN_BENCHMARKS
+    Logger::writeToLog("Transition graph: " + String(static_cast<int>(_Loops.size())) + " loops, "
+                       + String(transitions.getNumEdges()) + " edges, "
+                       + String(transitions.getMemoryBytes() / 1024.0, 1) + " KB");
+   #endif
 }
 
-void MarkovChain::initMatrix() {
-    for (int i = 0; i < inputMatrix.rows(); ++i){
-        for (int j = i + 1; j < inputMatrix.cols(); ++j){
-            if (i == j){
-                inputMatrix(i,j) = 1;
-                continue;
-            } else {
-                inputMatrix(i,j) = overlapExists(_Loops[i], _Loops[j]);
-                inputMatrix(j,i) = inputMatrix(i,j);
-            }
-        }
+//(sampsEnd, loop), sorted
+typedef std::vector<std::pair<int, int> > LoopEnds;
+
+//extends history with every loop ending where its last loop (or next, to start
+//with) begins, and counts next after each context that makes, once per order
+static void observePredecessors(VariableOrderModel& model, const std::vector<Loop>& loops,
+                                const LoopEnds& ends, int* history, int length, int next){
+    const int last  = length == 0 ? next : history[length - 1];
+    const int start = loops[last].sampsStart;
+    for (auto p = std::lower_bound(ends.begin(), ends.end(), std::make_pair(start, -1));
+         p != ends.end() && p->first == start; ++p){
+        if (p->second == last) continue;
+
+        history[length] = p->second;
+        if (length + 1 >= 2)
+            model.observeOrder(history, length + 1, next);
+        if (length + 1 < model.getMaxOrder())
+            observePredecessors(model, loops, ends, history, length + 1, next);
     }
 }
 
-void MarkovChain::computeDistances(){
-    
-    std::vector<std::string> feature_names(features, features + numFeatures);
-    for (int i = 0; i < inputMatrix.rows(); ++i) {
-        for (int j = i + 1; j < inputMatrix.cols(); ++j) {
-            //if loop doesn't overlap or is on the diagnol, skip it
-            if (inputMatrix(i,j) == 0 || i == j){
-                continue;
-            } else {
-                _REAL dist = 0.f;
-                for (int k = 0; k < feature_names.size(); ++k){
-                    dist += euclidean(_Loops.at(i).bin.value<essentia::Real>(feature_names[k]),
-                                      _Loops.at(j).bin.value<essentia::Real>(feature_names[k]));
-                }
-                inputMatrix(i,j) = dist;
-                inputMatrix(j,i) = inputMatrix(i,j);
-            }
-        }
-    }
+void MarkovChain::learnSourceOrder(int maxOrder){
+    const int numLoops = static_cast<int>(_Loops.size());
+
+    //loops are cut from delimiters, so a successor starts on exactly the sample its predecessor ends
+    LoopEnds ends;
+    ends.reserve(_Loops.size());
+    for (int i = 0; i < numLoops; ++i)
+        ends.push_back(std::make_pair(_Loops[i].sampsEnd, i));
+    std::sort(ends.begin(), ends.end());
+
+    //several loops usually end on the same delimiter, and the walk may arrive
+    //through any of them, so every chain of predecessors is a context of the loop
+    phrases = new VariableOrderModel(maxOrder);
+    int history[VariableOrderModel::maxSupportedOrder];
+    for (int i = 0; i < numLoops; ++i)
+        observePredecessors(*phrases, _Loops, ends, history, 0, i);
+
+    Logger::writeToLog("Source phrases: " + String(phrases->getNumContexts()) + " contexts ("
+                       + String(phrases->getNumDropped()) + " dropped), "
+                       + String((int) (phrases->getMemoryBytes() / 1024)) + " KB");
 }
 
-MATRIX MarkovChain::computeTransitionMatrix(){
-    MATRIX transitions(inputMatrix);
-    for (int i = 0; i < transitions.rows(); ++i){
-        essentia::Real rowSum = 0.f;
-        for (int j = 0; j < 2 * transitions.cols(); ++j){
-            if (j < transitions.cols()){
-                rowSum += transitions(i,j);
-            } else {
-                int k = j % transitions.cols();
-                transitions(i,k) /= rowSum;
-            }
-        }
-    }
-    return transitions;
+
+void MarkovChain::computeOverlapDistances(const FeatureMatrix& matrix, int maxNeighbours){
+    OverlapLists overlaps;
+    overlaps.build(_Loops);
+   #if JUCE_DEBUG
+    if (_Loops.size() <= 2000)
+        jassert(overlaps.matchesBruteForce(_Loops));
+   #endif
+
+    //each of the K overlapping pairs is measured once, in blocks of rows spread
+    //over all cores, and read from both of its rows
+    SimilarityBuilder builder(matrix, maxNeighbours);
+    builder.build(transitions, overlaps);
 }
 
+void MarkovChain::blendSpliceCosts(const BoundaryCache& boundaries, float amount){
+    jassert(aliases != nullptr);
+    const ScopedLock sl(aliases->getLock());
+    transitions.blendEdgeCosts([&boundaries](int from, int to){ return boundaries.spliceCost(from, to); },
+                               amount);
+    aliases->build();
+}
 
-std::vector<int> MarkovChain::markov(const MATRIX& transMat, int num_iters, int state){
-    juce::Random r;
-    std::vector<int> chain;
-    
-    for (int n = 0; n < num_iters - 1; ++n){
-        float probability = r.nextFloat();
-        for (int i = 0; i < transMat.cols(); ++i){
-            probability -= transMat(state,i);
-            if (probability < 0) {
-                break;
-            }
-            chain.push_back(i);
-        }
-    }
-    //for (auto& x : chain) std::cout << x << std::endl;
+void MarkovChain::removeLoop(int index){
+    jassert(aliases != nullptr);
+    const ScopedLock sl(aliases->getLock());
+    Array<int> changedRows;
+    transitions.removeState(index, changedRows);
+    for (int row : changedRows)
+        aliases->buildRow(row);
+}
+
+void MarkovChain::restoreLoop(int index){
+    jassert(aliases != nullptr);
+    const ScopedLock sl(aliases->getLock());
+    Array<int> changedRows;
+    transitions.restoreState(index, changedRows);
+    for (int row : changedRows)
+        aliases->buildRow(row);
+}
+
+std::vector<int> MarkovChain::markov(const TransitionGraph& graph, int num_iters, int state, int64 seed){
+    AliasTable table(graph);
+    MarkovWalker walker(table, state, seed);
+
+    //the start state, then one state per step
+    std::vector<int> chain(1, state);
+    walker.walk(num_iters - 1, chain);
     return chain;
 }
 
+void MarkovChain::benchmarkWalk(const TransitionGraph& graph, int numSteps){
+    if (graph.getNumStates() == 0) return;
+
+    double start = Time::getMillisecondCounterHiRes();
+    AliasTable table(graph);
+    const double buildMs = Time::getMillisecondCounterHiRes() - start;
+
+    MarkovWalker walker(table, 0, 1);
+    start = Time::getMillisecondCounterHiRes();
+    int visited = 0;
+    for (int n = 0; n < numSteps; ++n)
+        visited += walker.step();
+    const double walkMs = Time::getMillisecondCounterHiRes() - start;
+
+    Logger::writeToLog("MarkovWalker benchmark: alias tables " + String(buildMs, 2) + " ms, "
+                       + String(numSteps) + " steps in " + String(walkMs, 2) + " ms"
+                       + " (state sum " + String(visited) + ")");
+}
+
 //namespace (non-member) convenience function
     
     std::vector<int> generateMarkovChain(const std::vector<Loop>& loops, int itr, int start){
@@ -114,12 +170,9 @@ std::vector<int> MarkovChain::markov(const MATRIX& transMat, int num_iters, int
 */
         //BackgroundThread simThread(loops.size(), vals);
         //if (simThread.runThread()){
-            int row = loops.size(), col = loops.size();
-            MATRIX mat(row, col);
-            MarkovChain markovChain(loops, mat, row, col);
+            MarkovChain markovChain(loops);
             markovChain.computeDistances();
-            MATRIX transMatrix(markovChain.computeTransitionMatrix());
-            chain = markovChain.markov(transMatrix, itr, start);
+            chain = markovChain.markov(markovChain.getTransitionGraph(), itr, start);
         //} else
         //    simThread.threadComplete(true);
         
@@ -13,31 +13,83 @@
 
 
 #include "LoopGenerator.h"
-#include "MATRIX.h"
+#include "FeatureRegistry.h"
+#include "TransitionGraph.h"
+#include "FeatureMatrix.h"
+#include "SimilarityBuilder.h"
+#include "OverlapLists.h"
+#include "MarkovWalker.h"
+#include "MarkovGenerator.h"
+#include "BoundaryCache.h"
 
 
 namespace mkov{
 
 class MarkovChain {
 public:
-    MarkovChain(const std::vector<Loop>& _loops, MATRIX& inMat, int r, int c);
+    enum { defaultNeighbours = 16 };
+
+    /** Which loops may follow each other: only loops that overlap in the file
+        (the default), or any two loops. */
+    enum CandidateMode {
+        overlappingLoops = 0,
+        allLoops
+    };
+
+    explicit MarkovChain(const std::vector<Loop>& _loops);
     ~MarkovChain();
     
-    void computeDistances();
-    MATRIX computeTransitionMatrix();
-    std::vector<int> markov(const MATRIX& transMat, int iters, int state);
+    /** Declares the loop features computeDistances() reads. */
+    static void requireFeatures(FeatureRegistry& registry);
+
+    /** Builds the transition graph, keeping each loop's maxNeighbours most
+        similar candidates. */
+    void computeDistances(int maxNeighbours = defaultNeighbours, CandidateMode mode = overlappingLoops);
+    const TransitionGraph& getTransitionGraph() const { return transitions; }
+    /** Reweights the graph towards transitions that splice cleanly, judged
+        from the loops' cached head and tail frames. amount 0 leaves the
+        feature distances alone, 1 uses only the splice. Call once, after
+        computeDistances(). */
+    void blendSpliceCosts(const BoundaryCache& boundaries, float amount = 0.5f);
+    /** Valid after computeDistances(). */
+    AliasTable& getAliasTable() { jassert(aliases != nullptr); return *aliases; }
+
+    /** Takes a loop out of (or back into) the walk without rebuilding the
+        graph; only the rows leading to it are renormalised. Loop indices stay
+        the same. Call after computeDistances(). */
+    void removeLoop(int index);
+    void restoreLoop(int index);
+
+    /** How adventurous the walk is (1 = as measured). Safe to call from the
+        message thread while a generator is sampling the table. */
+    void setShiftiness(float temperature) { jassert(aliases != nullptr); aliases->setTemperature(temperature); }
+
+    /** Learns the phrases of the source track: the loops starting where a
+        loop ends are the ones that followed it, and every chain of up to
+        maxOrder such predecessors is a context. A MarkovGenerator given these can
+        carry on a phrase of the original instead of a similarity step. */
+    void learnSourceOrder(int maxOrder = 2);
+    /** Null until learnSourceOrder() has been called. */
+    const VariableOrderModel* getSourcePhrases() const noexcept { return phrases; }
+
+    /** iters states starting with state, from a walk seeded with seed. */
+    std::vector<int> markov(const TransitionGraph& graph, int iters, int state,
+                            int64 seed = Time::currentTimeMillis());
+
+    /** Logs alias table build time and the time for numSteps walker steps. */
+    static void benchmarkWalk(const TransitionGraph& graph, int numSteps = 1000000);
     
     template <typename T>
     T euclidean(T t1, T t2){ return sqrt((t2-t1)*(t2-t1)); }
     
 private:
-    int rows, cols;
-    const std::vector<Loop> _Loops;
-    MATRIX inputMatrix, transitionMatrix;
+    const std::vector<Loop>& _Loops;
+    TransitionGraph transitions;
+    juce::ScopedPointer<AliasTable> aliases;
+    juce::ScopedPointer<VariableOrderModel> phrases;
     const int numFeatures = 4;
-    
-    int overlapExists(const Loop& a, const Loop& b);
-    void initMatrix();
+
+    void computeOverlapDistances(const FeatureMatrix& matrix, int maxNeighbours);
 };
 
     std::vector<int> generateMarkovChain(const std::vector<Loop>& loops, int itr, int start);
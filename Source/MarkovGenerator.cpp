@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    MarkovGenerator.cpp
+    Created: 18 Oct 2026 11:20:43am
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "MarkovGenerator.h"
+
+namespace mkov{
+
+//the consumer never signals, so the producer polls; a loop lasts far longer than this
+static const int refillIntervalMs = 5;
+
+MarkovGenerator::MarkovGenerator(AliasTable& _table, int startState,
+                                 const VariableOrderModel* _phrases, float _phraseBlend,
+                                 int lookahead, int64 seed) :
+    Thread("Markov generator"), table(_table), fifo(lookahead), queue(static_cast<size_t>(lookahead)),
+    walker(_table, startState, seed), phrases(_phrases), phraseBlend(_phraseBlend),
+    random(seed + 1), discardState(idle), lastConsumed(startState), historyLength(1)
+{
+    history[0] = startState;
+
+    //ready before the first getNext(), even if the thread hasn't run yet
+    fill();
+    startThread();
+}
+
+MarkovGenerator::~MarkovGenerator(){
+    stopThread(1000);
+}
+
+int MarkovGenerator::getNext() noexcept {
+    //only the reader may move the read position, so both flushes happen here
+    if (discardState.get() != idle){
+        if (discardState.compareAndSetBool(readerFlushed, discardRequested)
+            || discardState.compareAndSetBool(idle, walkerReset))
+            fifo.finishedRead(fifo.getNumReady());
+        if (discardState.get() != idle)
+            return -1;
+    }
+
+    int start1, size1, start2, size2;
+    for (;;){
+        fifo.prepareToRead(1, start1, size1, start2, size2);
+        if (size1 == 0)
+            return -1;
+
+        const int next = queue[start1];
+        fifo.finishedRead(1);
+        if (!table.getGraph().isRemoved(next)){
+            lastConsumed.set(next);
+            return next;
+        }
+    }
+}
+
+void MarkovGenerator::fill(){
+    //held only for the few dozen O(1) steps, never by the reader
+    const ScopedLock sl(table.getLock());
+    if (discardState.get() != idle){
+        //nothing is queued until the reader has dropped what was queued before the reset
+        if (discardState.get() == readerFlushed){
+            walker.setState(lastConsumed.get());
+            history[0] = lastConsumed.get();
+            historyLength = 1;
+            discardState.set(walkerReset);
+        }
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(fifo.getFreeSpace(), start1, size1, start2, size2);
+
+    for (int n = 0; n < size1; ++n)
+        queue[start1 + n] = step();
+    for (int n = 0; n < size2; ++n)
+        queue[start2 + n] = step();
+
+    fifo.finishedWrite(size1 + size2);
+}
+
+int MarkovGenerator::step() noexcept {
+    int next = -1;
+    if (phrases != nullptr && random.nextFloat() < phraseBlend)
+        next = phrases->sample(history, historyLength, random.nextFloat(), 1.0f / table.getTemperature());
+
+    //unseen context, or a loop removed since it was learnt: first order instead
+    if (next < 0 || table.getGraph().isRemoved(next))
+        next = walker.step();
+    else
+        walker.setState(next);
+
+    for (int h = VariableOrderModel::maxSupportedOrder - 1; h > 0; --h)
+        history[h] = history[h - 1];
+    history[0] = next;
+    historyLength = jmin(historyLength + 1, (int) VariableOrderModel::maxSupportedOrder);
+    return next;
+}
+
+void MarkovGenerator::run(){
+    while (!threadShouldExit()){
+        if (fifo.getFreeSpace() > 0 || discardState.get() != idle)
+            fill();
+        wait(refillIntervalMs);
+    }
+}
+
+}
@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    MarkovGenerator.h
+    Created: 18 Oct 2026 11:20:43am
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef MARKOVGENERATOR_H_INCLUDED
+#define MARKOVGENERATOR_H_INCLUDED
+
+#include "JuceHeader.h"
+#include "MarkovWalker.h"
+#include "VariableOrderModel.h"
+
+namespace mkov{
+
+/*
+    An endless Markov walk. A background thread keeps a fixed-size lookahead
+    queue (an AbstractFifo) topped up with the next loop indices, and the
+    player takes them with getNext(), which never locks, waits or allocates.
+    Memory stays the same however long the performance runs.
+
+    Given a phrase model (e.g. MarkovChain::getSourcePhrases()), a fraction
+    phraseBlend of the steps continue a phrase it knows for the last few loops
+    instead of taking a first-order step. The model is only read, never taught
+    by the walk, so the walk can't reinforce its own choices; its counts are
+    tempered like the table, so the shiftiness still applies to those steps.
+    Without one the walk is purely first order.
+*/
+class MarkovGenerator : private Thread {
+public:
+    MarkovGenerator(AliasTable& table, int startState,
+                    const VariableOrderModel* phrases = nullptr, float phraseBlend = 0.0f,
+                    int lookahead = 64, int64 seed = Time::currentTimeMillis());
+    ~MarkovGenerator();
+
+    /** The next loop index, or -1 if the queue has run dry. Safe to call from
+        the audio or timer thread while the generator is running. Loops removed
+        from the graph after they were queued are skipped. */
+    int getNext() noexcept;
+
+    int getNumReady() const noexcept { return fifo.getNumReady(); }
+
+    /** Drops the queued lookahead, e.g. after the temperature changed, so the
+        change is heard within a loop or two. The walk then carries on from
+        the last loop getNext() returned, not from where the lookahead had got
+        to, and getNext() returns -1 until the first fresh step is queued. */
+    void discardQueued() noexcept { discardState.compareAndSetBool(discardRequested, idle); }
+
+    const AliasTable& getAliasTable() const noexcept { return table; }
+
+private:
+    AliasTable& table;
+    AbstractFifo fifo;
+    HeapBlock<int> queue;
+    //a discard is a handshake: the reader flushes, the generator steps back to
+    //lastConsumed, then the reader flushes whatever an unfinished fill() queued
+    enum { idle = 0, discardRequested, readerFlushed, walkerReset };
+    Atomic<int> discardState;
+    Atomic<int> lastConsumed;
+    MarkovWalker walker;
+    const VariableOrderModel* phrases;   //not owned, must outlive the generator
+    const float phraseBlend;
+    Random random;
+    int history[VariableOrderModel::maxSupportedOrder];
+    int historyLength;
+
+    void run() override;
+    void fill();
+    int step() noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE (MarkovGenerator)
+};
+
+}
+
+#endif  // MARKOVGENERATOR_H_INCLUDED
@@ -0,0 +1,28 @@
+/*
+  ==============================================================================
+
+    MarkovWalker.cpp
+    Created: 18 Oct 2026 10:02:19am
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "MarkovWalker.h"
+
+namespace mkov{
+
+MarkovWalker::MarkovWalker(AliasTable& t, int startState, int64 seed) :
+    table(t), random(seed), state(startState)
+{
+}
+
+MarkovWalker::~MarkovWalker(){}
+
+void MarkovWalker::walk(int numSteps, std::vector<int>& chain){
+    chain.reserve(chain.size() + static_cast<size_t>(jmax(0, numSteps)));
+    for (int n = 0; n < numSteps; ++n)
+        chain.push_back(step());
+}
+
+}
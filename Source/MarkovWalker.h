@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    MarkovWalker.h
+    Created: 18 Oct 2026 10:02:19am
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef MARKOVWALKER_H_INCLUDED
+#define MARKOVWALKER_H_INCLUDED
+
+#include <vector>
+#include "JuceHeader.h"
+#include "AliasTable.h"
+
+namespace mkov{
+
+/*
+    One random walk over a transition graph. Each step() is O(1) through the
+    shared AliasTable and yields exactly one state. The same seed and start
+    state always give the same walk.
+*/
+class MarkovWalker {
+public:
+    MarkovWalker(AliasTable& table, int startState, int64 seed = Time::currentTimeMillis());
+    ~MarkovWalker();
+
+    int  getState() const noexcept  { return state; }
+    void setState(int newState) noexcept { state = newState; }
+    void setSeed(int64 seed) noexcept { random.setSeed(seed); }
+
+    /** Moves to the next state and returns it. */
+    int step() noexcept {
+        const float slot = random.nextFloat();
+        state = table.sample(state, slot, random.nextFloat());
+        return state;
+    }
+
+    /** Appends numSteps states to chain. */
+    void walk(int numSteps, std::vector<int>& chain);
+
+private:
+    AliasTable& table;
+    Random random;
+    int state;
+
+    MarkovWalker(const MarkovWalker&);
+    MarkovWalker& operator=(const MarkovWalker&);
+};
+
+}
+
+#endif  // MARKOVWALKER_H_INCLUDED
@@ -0,0 +1,188 @@
+/*
+  ==============================================================================
+
+    OverlapLists.cpp
+    Created: 17 Oct 2026 11:12:44pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "OverlapLists.h"
+
+namespace mkov{
+
+OverlapLists::OverlapLists() : offsets(1, 0)
+{
+}
+
+OverlapLists::~OverlapLists(){}
+
+void OverlapLists::build(const std::vector<Loop>& loops){
+    const int numLoops = static_cast<int>(loops.size());
+
+    std::vector<int> order(static_cast<size_t>(numLoops));
+    for (int i = 0; i < numLoops; ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&loops](int a, int b){
+        return loops[a].sampsStart < loops[b].sampsStart;
+    });
+
+    //min-heap on end sample: whatever has ended by the next start is at the front
+    auto endsLater = [&loops](int a, int b){ return loops[a].sampsEnd > loops[b].sampsEnd; };
+    std::vector<int> active;
+    std::vector<std::pair<int, int> > pairs;
+
+    for (int x : order){
+        const Loop& loop = loops[x];
+        while (!active.empty() && loops[active.front()].sampsEnd <= loop.sampsStart){
+            std::pop_heap(active.begin(), active.end(), endsLater);
+            active.pop_back();
+        }
+        //an empty loop overlaps nothing, and must not be left in the heap
+        if (loop.sampsEnd <= loop.sampsStart)
+            continue;
+
+        //everything still active started no later and ends after this start
+        for (int a : active)
+            pairs.push_back(std::make_pair(jmin(a, x), jmax(a, x)));
+
+        active.push_back(x);
+        std::push_heap(active.begin(), active.end(), endsLater);
+    }
+
+    //counting sort of both directions of every pair into CSR
+    offsets.assign(static_cast<size_t>(numLoops) + 1, 0);
+    for (auto& p : pairs){
+        ++offsets[p.first + 1];
+        ++offsets[p.second + 1];
+    }
+    for (int i = 0; i < numLoops; ++i)
+        offsets[i + 1] += offsets[i];
+
+    neighbours.resize(pairs.size() * 2);
+    std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+    for (auto& p : pairs){
+        neighbours[fill[p.first]++]  = p.second;
+        neighbours[fill[p.second]++] = p.first;
+    }
+    for (int i = 0; i < numLoops; ++i)
+        std::sort(neighbours.begin() + offsets[i], neighbours.begin() + offsets[i + 1]);
+
+    //visiting the rows in order meets each row's lower neighbours in order too
+    mirrors.resize(neighbours.size());
+    std::vector<int> lower(offsets.begin(), offsets.end() - 1);
+    for (int i = 0; i < numLoops; ++i){
+        for (int e = offsets[i]; e < offsets[i + 1]; ++e){
+            const int j = neighbours[e];
+            if (j < i) continue;
+            mirrors[e] = lower[j];
+            mirrors[lower[j]++] = e;
+        }
+    }
+}
+
+bool OverlapLists::matchesBruteForce(const std::vector<Loop>& loops) const {
+    const int numLoops = static_cast<int>(loops.size());
+    if (numLoops != getNumLoops())
+        return false;
+
+    for (int i = 0; i < numLoops; ++i){
+        const int* next = begin(i);
+        for (int j = 0; j < numLoops; ++j){
+            if (j == i || !overlaps(loops[i], loops[j]))
+                continue;
+            if (next == end(i) || *next != j)
+                return false;
+            ++next;
+        }
+        if (next != end(i))
+            return false;
+
+        for (int e = getRowBegin(i); e < getRowBegin(i + 1); ++e)
+            if (neighbours[getMirror(e)] != i || getMirror(getMirror(e)) != e)
+                return false;
+    }
+    return true;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class OverlapListsTests : public UnitTest {
+public:
+    OverlapListsTests() : UnitTest("OverlapLists") {}
+
+    void runTest() override {
+        beginTest("Empty set");
+        {
+            std::vector<Loop> loops;
+            OverlapLists lists;
+            lists.build(loops);
+            expectEquals(lists.getNumLoops(), 0);
+            expectEquals(lists.getNumPairs(), 0);
+            expect(lists.matchesBruteForce(loops));
+        }
+
+        beginTest("Touching endpoints");
+        {
+            //end to start is not an overlap; one shared sample is
+            std::vector<Loop> loops;
+            addLoop(loops, 0, 100);
+            addLoop(loops, 100, 200);
+            addLoop(loops, 199, 300);
+            addLoop(loops, 300, 300);
+            OverlapLists lists;
+            lists.build(loops);
+            expect(lists.matchesBruteForce(loops));
+            expectEquals(lists.getNumPairs(), 1);
+            expectEquals(degree(lists, 0), 0);
+            expectEquals(degree(lists, 3), 0);
+        }
+
+        beginTest("Identical intervals");
+        {
+            std::vector<Loop> loops;
+            for (int i = 0; i < 5; ++i)
+                addLoop(loops, 1000, 2000);
+            OverlapLists lists;
+            lists.build(loops);
+            expect(lists.matchesBruteForce(loops));
+            expectEquals(lists.getNumPairs(), 10);
+        }
+
+        beginTest("Random loops against brute force");
+        {
+            Random random(0x0e7a);
+            for (int trial = 0; trial < 20; ++trial){
+                std::vector<Loop> loops;
+                const int numLoops = 1 + random.nextInt(400);
+                for (int i = 0; i < numLoops; ++i){
+                    //coarse positions so shared starts, ends and touches all turn up
+                    const int start = random.nextInt(200) * 50;
+                    addLoop(loops, start, start + random.nextInt(40) * 50);
+                }
+                OverlapLists lists;
+                lists.build(loops);
+                expect(lists.matchesBruteForce(loops), "trial " + String(trial));
+            }
+        }
+    }
+
+private:
+    static void addLoop(std::vector<Loop>& loops, int sampsStart, int sampsEnd){
+        loops.push_back(Loop());
+        loops.back().sampsStart = sampsStart;
+        loops.back().sampsEnd   = sampsEnd;
+    }
+
+    static int degree(const OverlapLists& lists, int i){
+        return static_cast<int>(lists.end(i) - lists.begin(i));
+    }
+};
+
+static OverlapListsTests overlapListsTests;
+
+#endif
+
+}
@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    OverlapLists.h
+    Created: 17 Oct 2026 11:12:44pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef OVERLAPLISTS_H_INCLUDED
+#define OVERLAPLISTS_H_INCLUDED
+
+#include <vector>
+#include "JuceHeader.h"
+#include "LoopGenerator.h"
+
+namespace mkov{
+
+/*
+    For every loop, the other loops whose sample ranges overlap it, stored CSR
+    style like the TransitionGraph. build() sweeps the loops in start order and
+    keeps the ones still sounding in a heap keyed on their end, so it costs
+    O(N log N + K) for K overlapping pairs instead of testing all N^2 pairs.
+    Every pair is stored both ways, and each entry knows its mirror (the entry
+    of the other loop's list that holds the same pair), so a value per pair can
+    be stored once and read from either loop.
+*/
+class OverlapLists {
+public:
+    OverlapLists();
+    ~OverlapLists();
+
+    void build(const std::vector<Loop>& loops);
+
+    /** Half-open ranges [sampsStart, sampsEnd) that share at least one sample.
+        Loops that only touch end to start do not overlap. */
+    static bool overlaps(const Loop& a, const Loop& b) noexcept {
+        return jmax(a.sampsStart, b.sampsStart) < jmin(a.sampsEnd, b.sampsEnd);
+    }
+
+    int getNumLoops() const noexcept { return static_cast<int>(offsets.size()) - 1; }
+    int getNumPairs() const noexcept { return static_cast<int>(neighbours.size()) / 2; }
+
+    /** The loops overlapping loop i, in ascending order. */
+    const int* begin(int i) const noexcept { return neighbours.data() + offsets[i]; }
+    const int* end(int i)   const noexcept { return neighbours.data() + offsets[i + 1]; }
+
+    /** Entry indices: loop i's list is entries [getRowBegin(i), getRowBegin(i + 1)). */
+    int getRowBegin(int i) const noexcept { return offsets[i]; }
+    int getNumEntries() const noexcept    { return static_cast<int>(neighbours.size()); }
+    /** The entry holding the same pair in the other loop's list. */
+    int getMirror(int entry) const noexcept { return mirrors[entry]; }
+
+    /** Compares the lists and their mirrors with the all-pairs definition; for debugging. */
+    bool matchesBruteForce(const std::vector<Loop>& loops) const;
+
+private:
+    std::vector<int> offsets, neighbours, mirrors;
+
+    OverlapLists(const OverlapLists&);
+    OverlapLists& operator=(const OverlapLists&);
+};
+
+}
+
+#endif  // OVERLAPLISTS_H_INCLUDED
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    SampleStore.cpp
+    Created: 17 Oct 2026 9:12:40am
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "SampleStore.h"
+#include "AudioAsset.h"
+
+namespace lgen{
+
+SampleStore::SampleStore(VEC_REAL& mono, double sr) : sampleRate(sr)
+{
+    owned.swap(mono);
+    data.setData(owned.data());
+    data.setSize(owned.size());
+}
+
+SampleStore::SampleStore(const AudioAsset& shared) :
+    asset(const_cast<AudioAsset*>(&shared)), sampleRate(shared.getSampleRate())
+{
+    data.setData(const_cast<_REAL*>(shared.getDecodedBuffer()->getReadPointer(0)));
+    data.setSize(static_cast<size_t>(shared.getNumSamples()));
+}
+
+SampleStore::~SampleStore(){}
+
+SampleStore::Ptr SampleStore::createFromAsset(const AudioAsset& asset, double targetSampleRate){
+    if (asset.getNumSamples() <= 0 || asset.getNumChannels() <= 0)
+        return nullptr;
+
+    //already what the analysis wants: read the player's samples in place
+    if (asset.getDecodedBuffer() != nullptr && asset.getNumChannels() == 1
+         && asset.getSampleRate() == targetSampleRate)
+        return new SampleStore(asset);
+
+    VEC_REAL mono;
+    downmix(asset, mono);
+    if (asset.getSampleRate() != targetSampleRate)
+        resample(mono, asset.getSampleRate(), targetSampleRate);
+
+    return new SampleStore(mono, targetSampleRate);
+}
+
+void SampleStore::downmix(const AudioAsset& asset, VEC_REAL& dest){
+    const int numChannels = asset.getNumChannels();
+    const int length      = asset.getNumSamples();
+    dest.resize(static_cast<size_t>(length));
+
+    //channel 0 lands in place; only the others need the block
+    AudioSampleBuffer block(jmax(1, numChannels - 1), AudioAsset::readBlockSize);
+    HeapBlock<float*> channels(static_cast<size_t>(numChannels));
+    for (int start = 0; start < length; start += AudioAsset::readBlockSize){
+        const int num = jmin((int) AudioAsset::readBlockSize, length - start);
+        float* out = dest.data() + start;
+        channels[0] = out;
+        for (int c = 1; c < numChannels; ++c)
+            channels[c] = block.getWritePointer(c - 1);
+        asset.read(channels, numChannels, 0, start, num);
+
+        //the same way essentia's MonoLoader does it (channel mean)
+        for (int c = 1; c < numChannels; ++c)
+            FloatVectorOperations::add(out, channels[c], num);
+        if (numChannels > 1)
+            FloatVectorOperations::multiply(out, 1.0f / numChannels, num);
+    }
+}
+
+void SampleStore::resample(VEC_REAL& buffer, double sourceRate, double targetRate){
+    const double ratio = sourceRate / targetRate;
+    VEC_REAL out(static_cast<size_t>(buffer.size() / ratio));
+    LagrangeInterpolator interpolator;
+    interpolator.process(ratio, buffer.data(), out.data(), static_cast<int>(out.size()));
+    buffer.swap(out);
+}
+
+}
@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    SampleStore.h
+    Created: 17 Oct 2026 9:12:40am
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef SAMPLESTORE_H_INCLUDED
+#define SAMPLESTORE_H_INCLUDED
+
+#include <vector>
+#include "JuceHeader.h"
+#include "essentia.h"
+#include "roguevector.h"
+
+typedef essentia::Real _REAL;
+typedef std::vector<essentia::Real> VEC_REAL;
+
+namespace lgen{
+
+class AudioAsset;
+
+//A VEC_REAL that points into someone else's samples; it never owns or frees them
+typedef essentia::RogueVector<essentia::Real> SampleView;
+
+/*
+    The mono samples of a loaded AudioAsset at the analysis sample rate.
+    It is immutable once created and shared by reference (SampleStore::Ptr),
+    so every analysis stage reads the same memory instead of keeping its own
+    VEC_REAL. A decoded mono asset already at the analysis rate is shared
+    outright; anything else (including every memory-mapped WAV) is read block
+    by block, downmixed and resampled if needed into one mono copy.
+*/
+class SampleStore : public ReferenceCountedObject {
+public:
+    typedef ReferenceCountedObjectPtr<SampleStore> Ptr;
+
+    static Ptr createFromAsset(const AudioAsset& asset, double targetSampleRate = 44100.0);
+    ~SampleStore();
+
+    const VEC_REAL& samples()      const noexcept { return data; }
+    const _REAL*    getData()      const noexcept { return data.data(); }
+    int    size()                  const noexcept { return static_cast<int>(data.size()); }
+    double getSampleRate()         const noexcept { return sampleRate; }
+    double getLengthInSeconds()    const noexcept { return data.size() / sampleRate; }
+
+    /** Points view at samples [start, end) so it can be fed to essentia algorithms
+        as a VEC_REAL. Nothing is copied or allocated. */
+    void getView(int start, int end, SampleView& view) const noexcept {
+        jassert(start >= 0 && start <= end && end <= size());
+        view.setData(const_cast<_REAL*>(data.data()) + start);
+        view.setSize(static_cast<size_t>(end - start));
+    }
+
+    /** Calls fn(const _REAL* block, int startSample, int numSamples) for consecutive
+        blocks of at most blockSize samples. No copies are made. */
+    template <typename BlockFunction>
+    void forEachBlock(int blockSize, BlockFunction fn) const {
+        for (int start = 0; start < size(); start += blockSize)
+            fn(data.data() + start, start, jmin(blockSize, size() - start));
+    }
+
+private:
+    SampleStore(VEC_REAL& mono, double sr);
+    SampleStore(const AudioAsset& shared);
+
+    static void downmix(const AudioAsset& asset, VEC_REAL& dest);
+    static void resample(VEC_REAL& buffer, double sourceRate, double targetRate);
+
+    VEC_REAL owned;                             //the mono copy, when there is one
+    SampleView data;                            //owned, or the asset's only channel
+    const ReferenceCountedObjectPtr<AudioAsset> asset;  //keeps shared samples alive
+    const double sampleRate;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleStore)
+};
+
+}
+
+#endif  // SAMPLESTORE_H_INCLUDED
@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+    SegmentQueue.cpp
+    Created: 18 Oct 2026 9:02:45pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "SegmentQueue.h"
+
+//like the generator, the producer polls; a segment lasts far longer than this
+static const int refillIntervalMs = 5;
+
+SegmentQueue::SegmentQueue(int capacity) :
+    fifo(capacity), segments(static_cast<size_t>(capacity))
+{
+}
+
+SegmentQueue::~SegmentQueue(){}
+
+bool SegmentQueue::push(const SegmentDescriptor& segment) noexcept {
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 == 0)
+        return false;
+
+    segments[start1] = segment;
+    fifo.finishedWrite(1);
+    return true;
+}
+
+bool SegmentQueue::pop(SegmentDescriptor& segment) noexcept {
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(1, start1, size1, start2, size2);
+    if (size1 == 0)
+        return false;
+
+    segment = segments[start1];
+    fifo.finishedRead(1);
+    return true;
+}
+
+//==============================================================================
+SegmentProducer::SegmentProducer(SegmentQueue& _queue, mkov::MarkovGenerator& _generator,
+                                 const std::vector<Loop>& loops, double sampleRate,
+                                 const SplicePlanner* _planner, const EffectParameters& _effects,
+                                 int startLoop) :
+    Thread("Segment producer"), queue(_queue), generator(_generator), planner(_planner), effects(_effects),
+    previousLoop(-1), pendingLoop(startLoop)
+{
+    nominalStarts.reserve(loops.size());
+    nominalEnds.reserve(loops.size());
+    for (auto& loop : loops){
+        nominalStarts.push_back(roundToInt(loop.start * sampleRate));
+        nominalEnds.push_back(roundToInt(loop.end * sampleRate));
+    }
+    //ready before the audio thread asks for the first segment
+    fill();
+    startThread();
+}
+
+SegmentProducer::~SegmentProducer(){
+    stopThread(1000);
+}
+
+SegmentDescriptor SegmentProducer::resolve(int from, int to) const noexcept {
+    SplicePlanner::Splice splice = { nominalStarts[to], 0 };
+    if (planner != nullptr && from >= 0)
+        splice = planner->getSplice(from, to);
+    const int exit = planner != nullptr ? planner->getExit(to) : nominalEnds[to];
+
+    const SegmentDescriptor segment = { to, splice.entry, jmax(1, exit - splice.entry), splice.fadeIndex,
+                                        effects.getSnapshot() };
+    return segment;
+}
+
+void SegmentProducer::fill(){
+    while (queue.getFreeSpace() > 0){
+        if (pendingLoop < 0)
+            pendingLoop = generator.getNext();
+        if (pendingLoop < 0)
+            return;
+
+        queue.push(resolve(previousLoop, pendingLoop));
+        previousLoop = pendingLoop;
+        pendingLoop = -1;
+    }
+}
+
+void SegmentProducer::run(){
+    while (!threadShouldExit()){
+        fill();
+        wait(refillIntervalMs);
+    }
+}
@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    SegmentQueue.h
+    Created: 18 Oct 2026 9:02:45pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef SEGMENTQUEUE_H_INCLUDED
+#define SEGMENTQUEUE_H_INCLUDED
+
+#include <vector>
+#include "JuceHeader.h"
+#include "LoopGenerator.h"
+#include "MarkovGenerator.h"
+#include "SplicePlanner.h"
+
+/** The effect settings a segment plays with. They are taken when the segment
+    is resolved, so a change is heard from the next queued segment on, in step
+    with the walk. */
+struct EffectSnapshot {
+    float gain;             //on top of the layer's share of the mix
+    float reverbWet;        //0 is dry; only the main walk's segments set the reverb
+};
+
+/*
+    The effect settings SegmentProducers resolve segments with. The message
+    thread publishes them and the producers read them; each is an atomic of
+    its own, so neither side locks.
+*/
+class EffectParameters {
+public:
+    EffectParameters() : gain(1.0f), reverbWet(0.0f) {}
+
+    void setGain(float newGain) noexcept     { gain.set(newGain); }
+    void setReverbWet(float newWet) noexcept { reverbWet.set(jlimit(0.0f, 1.0f, newWet)); }
+
+    EffectSnapshot getSnapshot() const noexcept {
+        const EffectSnapshot snapshot = { gain.get(), reverbWet.get() };
+        return snapshot;
+    }
+
+private:
+    Atomic<float> gain, reverbWet;
+
+    EffectParameters(const EffectParameters&);
+    EffectParameters& operator=(const EffectParameters&);
+};
+
+/** Everything the audio thread needs to play one loop, already resolved. */
+struct SegmentDescriptor {
+    int loop;               //only for display and statistics
+    int start, length;      //asset samples; start is the planned entry
+    int fadeIndex;          //crossfade into this segment (LoopSamplerSource)
+    EffectSnapshot effects;
+};
+
+/*
+    Single producer, single consumer ring of SegmentDescriptors on an
+    AbstractFifo. push() is only called by one thread and pop() by one other;
+    neither locks, waits or allocates.
+*/
+class SegmentQueue {
+public:
+    explicit SegmentQueue(int capacity);
+    ~SegmentQueue();
+
+    bool push(const SegmentDescriptor& segment) noexcept;
+    bool pop(SegmentDescriptor& segment) noexcept;
+
+    int getNumReady() const noexcept  { return fifo.getNumReady(); }
+    int getFreeSpace() const noexcept { return fifo.getFreeSpace(); }
+    /** Only while neither side is running. */
+    void clear() noexcept             { fifo.reset(); }
+
+private:
+    AbstractFifo fifo;
+    HeapBlock<SegmentDescriptor> segments;
+
+    SegmentQueue(const SegmentQueue&);
+    SegmentQueue& operator=(const SegmentQueue&);
+};
+
+/*
+    Keeps a SegmentQueue topped up from a MarkovGenerator on its own thread,
+    turning each loop index into a descriptor: splice entry, length to the
+    loop's exit and crossfade from the SplicePlanner (hard cuts at the nominal
+    loop points without one), plus a snapshot of the effect parameters. It
+    takes its own copy of the loop positions, so the audio thread never sees
+    the loop vector. The first segment is startLoop itself.
+*/
+class SegmentProducer : private Thread {
+public:
+    SegmentProducer(SegmentQueue& queue, mkov::MarkovGenerator& generator,
+                    const std::vector<Loop>& loops, double sampleRate,
+                    const SplicePlanner* planner, const EffectParameters& effects,
+                    int startLoop);
+    ~SegmentProducer();
+
+private:
+    SegmentQueue& queue;
+    mkov::MarkovGenerator& generator;
+    const SplicePlanner* planner;
+    const EffectParameters& effects;
+    std::vector<int> nominalStarts, nominalEnds;
+    int previousLoop, pendingLoop;
+
+    void run() override;
+    void fill();
+    SegmentDescriptor resolve(int from, int to) const noexcept;
+
+    SegmentProducer(const SegmentProducer&);
+    SegmentProducer& operator=(const SegmentProducer&);
+};
+
+
+#endif  // SEGMENTQUEUE_H_INCLUDED
@@ -10,44 +10,442 @@
 
 #include "ShiftyLooping.h"
 
-ShiftyLooper::ShiftyLooper() {
+//how long the message thread waits for the audio thread to let go; after that
+//the device is assumed to have stopped calling back
+static const int suspendTimeoutMs = 500;
+
+ShiftyLooper::ShiftyLooper() : sampler(voicesPerLayer * maxLayers), running(false), streamPos(0),
+                               reverbWet(0.0f), reverbEngaged(false)
+{
     shifting = false;
-    
+    layers.add(new Layer(0));
+}
+
+ShiftyLooper::~ShiftyLooper(){
+    suspend();
 }
 
+void ShiftyLooper::suspend(){
+    armed.set(0);
+    for (int waited = 0; active.get() != 0 && waited < suspendTimeoutMs; ++waited)
+        Thread::sleep(1);
+    if (active.get() != 0){
+        sampler.stopAllVoices();
+        running = false;
+        active.set(0);
+    }
+    for (int i = 0; i < layers.size(); ++i)
+        layers[i]->producer = nullptr;
+}
+
+void ShiftyLooper::setGenerator(mkov::MarkovGenerator* g, int startLoop){
+    suspend();
+    layers[0]->generator = g;
+    layers[0]->playingLoop.set(startLoop);
+}
+
+void ShiftyLooper::setLoops(const std::vector<Loop>& l){
+    suspend();
+    layers[0]->loops = l;
+}
+
+void ShiftyLooper::setAsset(const lgen::AudioAsset::Ptr& a){
+    suspend();
+    sampler.setAsset(a);
+}
+
+void ShiftyLooper::setSplicePlanner(const SplicePlanner* p){
+    suspend();
+    layers[0]->planner = p;
+}
+
+bool ShiftyLooper::addLayer(mkov::MarkovGenerator& g, const std::vector<Loop>& loops,
+                            const SplicePlanner* p, int startLoop, float gain){
+    if (layers.size() >= maxLayers || loops.empty())
+        return false;
+
+    suspend();
+    Layer* layer = new Layer(layers.size());
+    layer->generator = &g;
+    layer->loops     = loops;
+    layer->planner   = p;
+    layer->gain      = gain;
+    layer->playingLoop.set(startLoop);
+    layers.add(layer);
+    return true;
+}
+
+void ShiftyLooper::clearLayers(){
+    suspend();
+    layers.removeRange(1, layers.size() - 1);
+}
 
 void ShiftyLooper::shiftyLooping(){
-    static int itr = 1;
-    Loop curr;
-    if (shifting){
-        setLoopBetweenTimes(false);
-        stop();
-        Loop old = _Loops[markovChain[itr-1]];
-        curr = _Loops[markovChain[itr]];
-       // if (old.start > curr.start){
-        setLoopTimes(curr.start, curr.end);
-        setNextPositionOverride(old.start * 44100);
-       // } else {
-       //     this->setLoopTimes(curr.start, curr.end);
-       //     this->setNextPositionOverride(old.start * 44100);
-       // }
-        setLoopBetweenTimes(true);
-        start();
-        //int interval = (curr.end - curr.start)*1000;
-        //startTimer(interval + interval * 0.5);
-        if (itr+1 > markovChain.size()){
-            shifting = false;
-        } else {
-            itr++;
-            startTimer(((curr.end - old.start) * 44100));
+    const lgen::AudioAsset* asset = sampler.getAsset();
+    const Layer& main = *layers[0];
+    if (shifting && main.generator != nullptr && asset != nullptr && asset->getNumSamples() > 0
+        && !main.loops.empty()){
+        if (armed.get() == 0){
+            //fresh queues, each walk carrying on from the last loop it played
+            suspend();
+            float totalGain = 0.0f;
+            for (int i = 0; i < layers.size(); ++i)
+                if (layers[i]->generator != nullptr && !layers[i]->loops.empty())
+                    totalGain += layers[i]->gain;
+            for (int i = 0; i < layers.size(); ++i){
+                Layer& layer = *layers[i];
+                if (layer.generator == nullptr || layer.loops.empty())
+                    continue;
+                layer.queue.clear();
+                layer.mixGain = totalGain > 0.0f ? layer.gain / totalGain : 0.0f;
+                const int startLoop = jlimit(0, (int) layer.loops.size() - 1, layer.playingLoop.get());
+                layer.graph    = &layer.generator->getAliasTable().getGraph();
+                layer.producer = new SegmentProducer(layer.queue, *layer.generator, layer.loops,
+                                                     asset->getSampleRate(), layer.planner, effects, startLoop);
+            }
         }
+        //the switches themselves happen in getNextAudioBlock()
+        setLoopBetweenTimes(false);
+        if (!isPlaying())
+            start();
+        armed.set(1);
     } else
         return;
 
 
 }
 
-void ShiftyLooper::timerCallback(){
-    //shifting = !(shifting);
-    shiftyLooping();
-}
\ No newline at end of file
+//==============================================================================
+void ShiftyLooper::prepareToPlay(int samplesPerBlockExpected, double sampleRate){
+    AudioFilePlayerExt::prepareToPlay(samplesPerBlockExpected, sampleRate);
+    sampler.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    reverb.setSampleRate(sampleRate);
+}
+
+void ShiftyLooper::getNextAudioBlock(const AudioSourceChannelInfo& info){
+    if (isPlaying()){
+        //announce first, then look: suspend() disarms first, then waits
+        active.set(1);
+        if (armed.get() != 0){
+            renderScheduled(info);
+            return;
+        }
+    } else {
+        //stopping or pausing ends shifty looping; resuming plays the file normally
+        armed.set(0);
+    }
+
+    if (running){
+        sampler.stopAllVoices();
+        running = false;
+    }
+    active.set(0);
+    AudioFilePlayerExt::getNextAudioBlock(info);
+}
+
+bool ShiftyLooper::popSegment(Layer& layer, SegmentDescriptor& segment) noexcept {
+    //resolved before the loop was removed; the segment after it was spliced from it, which is near enough
+    while (layer.queue.pop(segment))
+        if (layer.graph == nullptr || !layer.graph->isRemoved(segment.loop))
+            return true;
+    return false;
+}
+
+void ShiftyLooper::startSegment(Layer& layer, const SegmentDescriptor& segment){
+    layer.current = segment;
+    layer.playingLoop.set(segment.loop);
+    //the previous voice reached its exit on this very sample, so there is no gap
+    layer.currentVoice = sampler.startVoice(layer.voices, segment.start, segment.length,
+                                            layer.mixGain * segment.effects.gain, segment.fadeIndex);
+    layer.switchAt = streamPos + sampler.getOutputLength(segment.length);
+    if (&layer == layers.getUnchecked(0))
+        setReverbWet(segment.effects.reverbWet);
+}
+
+void ShiftyLooper::setReverbWet(float wet) noexcept {
+    if (wet == reverbWet)
+        return;
+    reverbWet = wet;
+    reverbEngaged = reverbEngaged || wet > 0.0f;
+
+    //the Reverb doubles the dry level; the dry signal only gives way halfway to the wet
+    Reverb::Parameters parameters;
+    parameters.dryLevel = 0.5f * (1.0f - 0.5f * wet);
+    parameters.wetLevel *= wet;
+    reverb.setParameters(parameters);
+}
+
+void ShiftyLooper::switchSegment(Layer& layer){
+    //the sampler's own count of what the voice rendered, against where the segment should have ended
+    if (layer.currentVoice >= 0){
+        const double exit = layer.current.start + layer.current.length;
+        const int64 error = roundToInt(std::abs(sampler.getSourcePosition(layer.currentVoice) - exit));
+        if (error > maxErrorSamples.get())
+            maxErrorSamples.set(error);
+    }
+    ++switches;
+
+    SegmentDescriptor next;
+    if (!popSegment(layer, next)){
+        ++underruns;
+        next = layer.current;
+    }
+    //the outgoing voice plays on past its exit while the new one fades in
+    sampler.releaseVoice(layer.currentVoice, next.fadeIndex);
+    startSegment(layer, next);
+}
+
+void ShiftyLooper::renderScheduled(const AudioSourceChannelInfo& info){
+    info.clearActiveBufferRegion();
+    if (!running){
+        streamPos = 0;
+        for (int i = 0; i < layers.size(); ++i)
+            layers[i]->running = false;
+        reverb.reset();
+        setReverbWet(0.0f);
+        reverbEngaged = false;
+        running = true;
+    }
+
+    //a layer joins as soon as its producer has something ready
+    for (int i = 0; i < layers.size(); ++i){
+        Layer& layer = *layers[i];
+        SegmentDescriptor first;
+        if (!layer.running && popSegment(layer, first)){
+            first.fadeIndex = 0;
+            startSegment(layer, first);
+            layer.running = true;
+        }
+    }
+
+    int done = 0;
+    while (done < info.numSamples){
+        //never run past a switch: the block is split exactly at the next one of any layer
+        int64 splitAt = streamPos + (info.numSamples - done);
+        for (int i = 0; i < layers.size(); ++i)
+            if (layers[i]->running)
+                splitAt = jmin(splitAt, layers[i]->switchAt);
+
+        const int num = static_cast<int>(splitAt - streamPos);
+        sampler.renderVoices(*info.buffer, info.startSample + done, num);
+        if (reverbEngaged){
+            float* const left = info.buffer->getWritePointer(0, info.startSample + done);
+            if (info.buffer->getNumChannels() > 1)
+                reverb.processStereo(left, info.buffer->getWritePointer(1, info.startSample + done), num);
+            else
+                reverb.processMono(left, num);
+        }
+
+        streamPos  += num;
+        done       += num;
+        for (int i = 0; i < layers.size(); ++i)
+            if (layers[i]->running && streamPos == layers[i]->switchAt)
+                switchSegment(*layers[i]);
+    }
+}
+
+ShiftyLooper::TimingStats ShiftyLooper::getTimingStats() const noexcept {
+    const TimingStats stats = { switches.get(), maxErrorSamples.get(), underruns.get() };
+    return stats;
+}
+
+void ShiftyLooper::logTimingStats() const {
+    const TimingStats stats = getTimingStats();
+    Logger::writeToLog("Shifty looping: " + String(stats.switches) + " switches, max error "
+                       + String(stats.maxErrorSamples) + " samples, "
+                       + String(stats.underruns) + " underruns");
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+static const EffectSnapshot unity = { 1.0f, 0.0f };
+
+class ShiftyLooperTests : public UnitTest {
+public:
+    ShiftyLooperTests() : UnitTest("ShiftyLooper") {}
+
+    void runTest() override {
+        beginTest("Switches at the device rate");
+        checkSwitches(44100.0, 44100.0);
+
+        beginTest("Switches when resampling up");
+        checkSwitches(44100.0, 48000.0);
+
+        beginTest("Removed loops are skipped");
+        checkRemovedLoops();
+
+        beginTest("Layers keep their own voices");
+        checkLayerVoices();
+
+        beginTest("Segments play with their own effects");
+        checkEffects();
+    }
+
+private:
+    enum { assetLength = 60000, numSegments = 40, maxBlockSize = 700 };
+
+    //the asset holds each sample's own index, so the output says which one played
+    void checkSwitches(double assetRate, double deviceRate){
+        AudioSampleBuffer indices(1, assetLength);
+        for (int n = 0; n < assetLength; ++n)
+            indices.setSample(0, n, static_cast<float>(n));
+
+        ShiftyLooper looper;
+        looper.setAsset(lgen::AudioAsset::createFromBuffer(indices, assetRate));
+        looper.prepareToPlay(maxBlockSize, deviceRate);
+        const double ratio = assetRate / deviceRate;
+
+        //odd lengths, often several to a block; the last one outlasts the final block
+        Random random(0x5e9);
+        std::vector<SegmentDescriptor> planned;
+        std::vector<int64> boundaries(1, 0);
+        for (int k = 0; k < numSegments; ++k){
+            const int length = k == numSegments - 1 ? assetLength / 2 : 150 + random.nextInt(1500);
+            const SegmentDescriptor segment = { k, 2 + random.nextInt(assetLength - length - 8), length, 0, unity };
+            planned.push_back(segment);
+            boundaries.push_back(boundaries.back() + (int64) std::ceil(length / ratio));
+        }
+
+        ShiftyLooper::Layer& main = *looper.layers[0];
+        AudioSampleBuffer block(2, maxBlockSize);
+        std::vector<float> output;
+        int queued = 0;
+        while ((int64) output.size() < boundaries[numSegments - 1]){
+            while (queued < numSegments && main.queue.push(planned[queued]))
+                ++queued;
+
+            const int blockSize = 1 + random.nextInt(maxBlockSize - 1);
+            looper.renderScheduled(AudioSourceChannelInfo(&block, 0, blockSize));
+            for (int n = 0; n < blockSize; ++n)
+                output.push_back(block.getSample(0, n));
+        }
+
+        const float tolerance = ratio == 1.0 ? 0.0f : 0.05f;
+        int wrongSegments = 0;
+        for (int k = 0; k < numSegments - 1; ++k){
+            //the switch sample itself, and every sample up to the next one
+            for (int64 t = boundaries[k]; t < boundaries[k + 1]; ++t){
+                const double expected = planned[k].start + (t - boundaries[k]) * ratio;
+                if (std::abs(output[(size_t) t] - expected) > tolerance){
+                    logMessage("segment " + String(k) + " wrong at output sample " + String(t)
+                               + ": " + String(output[(size_t) t]) + " instead of " + String(expected));
+                    ++wrongSegments;
+                    break;
+                }
+            }
+        }
+        expectEquals(wrongSegments, 0);
+
+        const ShiftyLooper::TimingStats stats = looper.getTimingStats();
+        expectEquals((int) stats.switches, numSegments - 1);
+        expectEquals((int) stats.underruns, 0);
+        expect(stats.maxErrorSamples <= (ratio == 1.0 ? 0 : (int64) std::ceil(ratio)));
+    }
+
+    void checkRemovedLoops(){
+        enum { numLoops = 5, loopLength = 1000 };
+        AudioSampleBuffer indices(1, numLoops * 2 * loopLength);
+        for (int n = 0; n < indices.getNumSamples(); ++n)
+            indices.setSample(0, n, static_cast<float>(n));
+
+        //every loop may follow every other
+        std::vector<std::vector<mkov::TransitionGraph::Neighbour> > rows(numLoops);
+        for (int i = 0; i < numLoops; ++i)
+            for (int j = 0; j < numLoops; ++j)
+                if (i != j){
+                    const mkov::TransitionGraph::Neighbour n = { 1.0f, j };
+                    rows[i].push_back(n);
+                }
+        mkov::TransitionGraph graph;
+        graph.assign(rows, numLoops);
+        Array<int> changedRows;
+        graph.removeState(2, changedRows);
+
+        ShiftyLooper looper;
+        looper.setAsset(lgen::AudioAsset::createFromBuffer(indices, 44100.0));
+        looper.prepareToPlay(loopLength, 44100.0);
+        ShiftyLooper::Layer& main = *looper.layers[0];
+        main.graph = &graph;
+        AudioSampleBuffer block(1, loopLength);
+        int queued = 0;
+        for (int k = 0; k < 3; ++k){
+            //the queue holds one less than its capacity
+            while (queued < 4){
+                const SegmentDescriptor segment = { queued, queued * 2 * loopLength, loopLength, 0, unity };
+                if (!main.queue.push(segment)) break;
+                ++queued;
+            }
+            looper.renderScheduled(AudioSourceChannelInfo(&block, 0, loopLength));
+            const int expectedLoop = k < 2 ? k : 3;
+            expectEquals((int) block.getSample(0, 0), expectedLoop * 2 * loopLength);
+        }
+    }
+
+    //fades far longer than the segments make the main walk want more voices than it owns
+    void checkLayerVoices(){
+        AudioSampleBuffer indices(1, assetLength);
+        for (int n = 0; n < assetLength; ++n)
+            indices.setSample(0, n, static_cast<float>(n));
+
+        ShiftyLooper looper;
+        looper.setAsset(lgen::AudioAsset::createFromBuffer(indices, 44100.0));
+        looper.prepareToPlay(50, 44100.0);
+        ShiftyLooper::Layer& main = *looper.layers[0];
+        ShiftyLooper::Layer& other = *looper.layers.add(new ShiftyLooper::Layer(1));
+
+        const SegmentDescriptor held = { 0, 1000, assetLength / 2, 0, unity };
+        other.queue.push(held);
+
+        AudioSampleBuffer block(1, 50);
+        for (int b = 0; b < 40; ++b){
+            const SegmentDescriptor shortOne = { 1, 100 * b, 100, LoopSamplerSource::numFadeLengths, unity };
+            main.queue.push(shortOne);
+            looper.renderScheduled(AudioSourceChannelInfo(&block, 0, 50));
+        }
+
+        expect(main.voices.contains(main.currentVoice));
+        expect(other.voices.contains(other.currentVoice));
+        //never restarted or cut off by the main walk
+        expect(looper.sampler.isVoiceActive(other.currentVoice));
+        expectEquals(looper.sampler.getSourcePosition(other.currentVoice), 1000.0 + 40 * 50);
+    }
+
+    //published after the first segment was resolved, so only the second one changes
+    void checkEffects(){
+        enum { loopLength = 1000 };
+        AudioSampleBuffer indices(1, 4 * loopLength);
+        for (int n = 0; n < indices.getNumSamples(); ++n)
+            indices.setSample(0, n, static_cast<float>(n));
+
+        ShiftyLooper looper;
+        looper.setAsset(lgen::AudioAsset::createFromBuffer(indices, 44100.0));
+        looper.prepareToPlay(loopLength, 44100.0);
+        ShiftyLooper::Layer& main = *looper.layers[0];
+
+        const SegmentDescriptor first = { 0, 0, loopLength, 0, looper.getEffectParameters().getSnapshot() };
+        looper.getEffectParameters().setGain(0.5f);
+        const SegmentDescriptor second = { 1, 2 * loopLength, loopLength, 0, looper.getEffectParameters().getSnapshot() };
+        main.queue.push(first);
+        main.queue.push(second);
+
+        AudioSampleBuffer block(2, loopLength);
+        looper.renderScheduled(AudioSourceChannelInfo(&block, 0, loopLength));
+        expectEquals(block.getSample(0, 10), 10.0f);
+        looper.renderScheduled(AudioSourceChannelInfo(&block, 0, loopLength));
+        expectEquals(block.getSample(0, 10), 0.5f * (2 * loopLength + 10));
+
+        //a wet segment leaves the dry signal at half and adds the reverb to it
+        looper.getEffectParameters().setGain(1.0f);
+        looper.getEffectParameters().setReverbWet(1.0f);
+        const SegmentDescriptor wet = { 0, 0, loopLength, 0, looper.getEffectParameters().getSnapshot() };
+        main.queue.push(wet);
+        looper.renderScheduled(AudioSourceChannelInfo(&block, 0, loopLength));
+        expect(looper.reverbEngaged);
+        expect(std::abs(block.getSample(0, loopLength - 1) - 0.5f * (loopLength - 1)) > 1.0f);
+    }
+};
+
+static ShiftyLooperTests shiftyLooperTests;
+
+#endif
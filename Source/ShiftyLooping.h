@@ -13,26 +13,93 @@
 
 #include "JuceHeader.h"
 #include "LoopGenerator.h"
+#include "AudioAsset.h"
+#include "LoopSamplerSource.h"
+#include "MarkovGenerator.h"
+#include "SplicePlanner.h"
+#include "SegmentQueue.h"
 
+/*
+    The file player, plus shifty looping scheduled on the audio thread. Once
+    shiftyLooping() arms it, a SegmentProducer thread turns the generator's
+    walk into fully resolved SegmentDescriptors (entry, length, crossfade)
+    and getNextAudioBlock() takes them from a lock-free SegmentQueue,
+    switching LoopSamplerSource voices at the exact output sample where each
+    segment ends. Segments whose loop was removed from the graph after they
+    were queued are skipped. The render path reads no shared containers
+    and takes no locks. Each switch records how far the outgoing
+    voice had actually played from its segment's planned exit
+    (getTimingStats()).
+
+    Segments are planned in asset samples and the sampler resamples them to
+    the device rate, so switch points are scheduled in output samples.
+    Shifty looping plays from the sampler, not through the file player's
+    SoundTouch chain: the playback settings (pitch, tempo, rate) only apply
+    to ordinary playback.
+
+    Up to maxLayers walks can play at once, e.g. bass, texture and drum
+    loops (see LoopLayer). Layer 0 is the main walk set up by setGenerator(),
+    setLoops() and setSplicePlanner(); addLayer() stacks more on top. Every
+    layer has its own generator, queue and producer and owns two sampler
+    voices that no other layer can steal, and the block is split at
+    whichever layer switches next. Layer gains are scaled to sum to 1 when
+    shifty looping starts, so the stacked walks peak no higher than one.
+
+    Changing the generator, loops, asset or planner first suspends the
+    scheduler: the message thread disarms it and waits (at most a block or
+    two) for the audio thread to let go, then swaps things over.
+*/
 class ShiftyLooper :
                      public drow::AudioFilePlayerExt,
-                     public drow::AudioFilePlayer::Listener,
-                     public Timer
+                     public drow::AudioFilePlayer::Listener
 
 
 {
 public:
     ShiftyLooper();
-    ~ShiftyLooper(){}
+    ~ShiftyLooper();
 
     void setShifting(bool shouldShift){shifting = shouldShift;
+        if (!shouldShift) armed.set(0);
     }
-    void setMarkov(const std::vector<int>& mc){ markovChain = mc;}
-    void setLoops(const std::vector<Loop>& l){ _Loops = l;}
-    
+    /** Loops are drawn from the generator for as long as shifting is on.
+        startLoop is the loop playing when it begins. */
+    void setGenerator(mkov::MarkovGenerator* g, int startLoop);
+    void setLoops(const std::vector<Loop>& l);
+    /** The samples shifty looping plays from. */
+    void setAsset(const lgen::AudioAsset::Ptr& a);
+    /** May be nullptr; must stay alive until replaced. */
+    void setSplicePlanner(const SplicePlanner* p);
+
+    enum { maxLayers = 4 };
+    /** Plays another walk on top of the main one. The generator, loops and
+        planner must stay alive until clearLayers(). gain is relative to the
+        main walk's 1. Returns false when all maxLayers are in use. */
+    bool addLayer(mkov::MarkovGenerator& g, const std::vector<Loop>& loops,
+                  const SplicePlanner* p, int startLoop, float gain);
+    /** Removes every layer but the main walk. */
+    void clearLayers();
+    int  getNumLayers() const noexcept { return layers.size(); }
+
+    /** Each segment takes these as its producer resolves it, so changes are
+        heard in step with the walk. The gain scales every layer; the reverb
+        runs on the whole mix and follows the main walk's segments. */
+    EffectParameters& getEffectParameters() noexcept { return effects; }
+
+    /** Arms the audio-thread scheduler; it runs while the player is playing. */
     void shiftyLooping();
-    
-    void timerCallback() override;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void getNextAudioBlock(const AudioSourceChannelInfo& info) override;
+
+    struct TimingStats {
+        int64 switches;         //loop changes made
+        int64 maxErrorSamples;  //worst distance, in asset samples, between where a voice had
+                                //played to when it was switched and its segment's exit
+        int64 underruns;        //no segment was ready; the current one repeated
+    };
+    TimingStats getTimingStats() const noexcept;
+    void logTimingStats() const;
     
     //drow
     void fileChanged(drow::AudioFilePlayer* player) {}
@@ -40,9 +107,64 @@ public:
     void playerStoppedOrStarted(drow::AudioFilePlayer* player){}
 
 private:
+    enum { segmentLookahead = 4, voicesPerLayer = 2 };
+
+    struct Layer {
+        explicit Layer(int index) : generator(nullptr), graph(nullptr), planner(nullptr), gain(1.0f),
+                                    voices(index * voicesPerLayer, (index + 1) * voicesPerLayer), mixGain(1.0f),
+                                    queue(segmentLookahead), running(false), currentVoice(0), switchAt(0)
+        {
+            zerostruct(current);
+        }
+
+        //message thread only
+        mkov::MarkovGenerator* generator;
+        const mkov::TransitionGraph* graph; //the generator's, for isRemoved() on the render thread
+        std::vector<Loop> loops;
+        const SplicePlanner* planner;
+        float gain;
+        ScopedPointer<SegmentProducer> producer;
+
+        //set while suspended, read by the render thread
+        const Range<int> voices;    //the sampler voices only this layer uses
+        float mixGain;              //gain over the sum of every playing layer's gain
+
+        SegmentQueue queue;
+        Atomic<int> playingLoop;    //where a re-armed walk carries on from
+
+        //render thread only
+        bool running;
+        SegmentDescriptor current;
+        int currentVoice;
+        int64 switchAt;
+    };
+
+    //message thread only
     bool shifting;
-    std::vector<Loop> _Loops;
-    std::vector<int> markovChain;
+    OwnedArray<Layer> layers;   //the main walk first; only changed while suspended
+    EffectParameters effects;   //read by the producers
+
+    LoopSamplerSource sampler;
+    Atomic<int> armed;          //message thread: play shifty
+    Atomic<int> active;         //audio thread: may be touching the sampler and queues
+
+    //render thread only
+    bool running;
+    int64 streamPos;            //output samples since the scheduler started
+    Reverb reverb;
+    float reverbWet;            //the main walk's current segment's
+    bool reverbEngaged;         //once on, it runs until restarted so its tail dies away
+
+    Atomic<int64> switches, maxErrorSamples, underruns;
+
+    void suspend();
+    bool popSegment(Layer& layer, SegmentDescriptor& segment) noexcept;
+    void startSegment(Layer& layer, const SegmentDescriptor& segment);
+    void switchSegment(Layer& layer);
+    void setReverbWet(float wet) noexcept;
+    void renderScheduled(const AudioSourceChannelInfo& info);
+
+    friend class ShiftyLooperTests;
    
     
     ShiftyLooper(const ShiftyLooper&);
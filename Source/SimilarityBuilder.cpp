@@ -0,0 +1,224 @@
+/*
+  ==============================================================================
+
+    SimilarityBuilder.cpp
+    Created: 17 Oct 2026 10:31:16pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "SimilarityBuilder.h"
+
+namespace mkov{
+
+/*
+    One per worker thread, re-added to the pool every round. It claims the
+    round's tiles one at a time, like LoopFeatureJob claims loops.
+*/
+class SimilarityTileJob : public ThreadPoolJob {
+public:
+    SimilarityTileJob(SimilarityBuilder& b, int tileSize) :
+        ThreadPoolJob("Similarity tiles"), builder(b), scratch(static_cast<size_t>(tileSize)),
+        round(nullptr), nextTile(nullptr) {}
+
+    void setRound(const std::vector<SimilarityBuilder::Tile>& tiles, Atomic<int>& next){
+        round = &tiles;
+        nextTile = &next;
+    }
+
+    JobStatus runJob() override {
+        const int numTiles = static_cast<int>(round->size());
+        for (int t = ++*nextTile - 1; t < numTiles; t = ++*nextTile - 1){
+            if (shouldExit()) break;
+            builder.computeTile((*round)[t], scratch.data());
+        }
+        return jobHasFinished;
+    }
+
+private:
+    SimilarityBuilder& builder;
+    std::vector<float> scratch;
+    const std::vector<SimilarityBuilder::Tile>* round;
+    Atomic<int>* nextTile;
+};
+
+/*
+    The sparse version: claims blocks of rows until none are left, either
+    measuring their pairs or picking their nearest. Each row only writes its
+    own entries, so nothing is shared.
+*/
+class SimilarityRowJob : public ThreadPoolJob {
+public:
+    enum Pass { measure, select };
+
+    SimilarityRowJob(SimilarityBuilder& b, const OverlapLists& c, Pass p, Atomic<int>& next) :
+        ThreadPoolJob("Similarity rows"), builder(b), candidates(c), pass(p), nextBlock(next) {}
+
+    JobStatus runJob() override {
+        for (int block = ++nextBlock - 1; block < builder.numBlocks; block = ++nextBlock - 1){
+            if (shouldExit()) break;
+            if (pass == measure)
+                builder.measureRows(candidates, block);
+            else
+                builder.selectRows(candidates, block);
+        }
+        return jobHasFinished;
+    }
+
+private:
+    SimilarityBuilder& builder;
+    const OverlapLists& candidates;
+    const Pass pass;
+    Atomic<int>& nextBlock;
+};
+
+SimilarityBuilder::SimilarityBuilder(const FeatureMatrix& m, int k, int tile) :
+    matrix(m), maxNeighbours(k), tileSize(tile),
+    numBlocks((m.getNumLoops() + tile - 1) / tile)
+{
+}
+
+SimilarityBuilder::~SimilarityBuilder(){}
+
+void SimilarityBuilder::scheduleRounds(int numBlocks, std::vector<std::vector<Tile> >& rounds){
+    rounds.clear();
+
+    //the diagonal tiles never share rows with each other, so they make one round
+    rounds.push_back(std::vector<Tile>());
+    for (int b = 0; b < numBlocks; ++b){
+        const Tile t = { b, b };
+        rounds.back().push_back(t);
+    }
+
+    //circle method: block 0 stays put while the rest rotate, so every pair of
+    //blocks meets exactly once and each block plays once per round. An odd
+    //count gets a dummy block whose opponent sits the round out
+    const int n = numBlocks + (numBlocks & 1);
+    for (int r = 0; r < n - 1; ++r){
+        rounds.push_back(std::vector<Tile>());
+        for (int p = 0; p < n / 2; ++p){
+            const int a = (p == 0) ? 0 : 1 + (r + p - 1) % (n - 1);
+            const int b = 1 + (r + n - 2 - p) % (n - 1);
+            if (a >= numBlocks || b >= numBlocks)
+                continue;
+            const Tile t = { jmin(a, b), jmax(a, b) };
+            rounds.back().push_back(t);
+        }
+    }
+}
+
+void SimilarityBuilder::computeTile(const Tile& tile, float* scratch){
+    const int numLoops = matrix.getNumLoops();
+    const int rowStart = tile.rowBlock * tileSize, rowEnd = jmin(numLoops, rowStart + tileSize);
+    const int colStart = tile.colBlock * tileSize, colEnd = jmin(numLoops, colStart + tileSize);
+    const bool diagonal = tile.rowBlock == tile.colBlock;
+
+    for (int i = rowStart; i < rowEnd; ++i){
+        //only the upper triangle; each distance is then used for both rows
+        const int first = diagonal ? i + 1 : colStart;
+        const int num   = colEnd - first;
+        if (num <= 0) continue;
+
+        matrix.distancesFrom(i, first, num, scratch);
+        for (int n = 0; n < num; ++n){
+            const int j = first + n;
+            if (isCandidate && !isCandidate(i, j))
+                continue;
+            const TransitionGraph::Neighbour toJ = { scratch[n], j }, toI = { scratch[n], i };
+            TransitionGraph::keepNearest(nearest[i], toJ, maxNeighbours);
+            TransitionGraph::keepNearest(nearest[j], toI, maxNeighbours);
+        }
+    }
+}
+
+void SimilarityBuilder::measureRows(const OverlapLists& candidates, int rowBlock){
+    const int rowStart = rowBlock * tileSize;
+    const int rowEnd   = jmin(candidates.getNumLoops(), rowStart + tileSize);
+
+    for (int i = rowStart; i < rowEnd; ++i){
+        //the lists are sorted, so the pairs above the diagonal are the tail of the row
+        const int* above = std::upper_bound(candidates.begin(i), candidates.end(i), i);
+        const int num = static_cast<int>(candidates.end(i) - above);
+        if (num <= 0) continue;
+
+        const int entry = candidates.getRowBegin(i) + static_cast<int>(above - candidates.begin(i));
+        matrix.distancesTo(i, above, num, pairDistances.data() + entry);
+    }
+}
+
+void SimilarityBuilder::selectRows(const OverlapLists& candidates, int rowBlock){
+    const int rowStart = rowBlock * tileSize;
+    const int rowEnd   = jmin(candidates.getNumLoops(), rowStart + tileSize);
+
+    for (int i = rowStart; i < rowEnd; ++i){
+        const int* row = candidates.begin(i);
+        const int begin = candidates.getRowBegin(i), end = candidates.getRowBegin(i + 1);
+        for (int e = begin; e < end; ++e){
+            const int j = row[e - begin];
+            const float d = pairDistances[j > i ? e : candidates.getMirror(e)];
+            const TransitionGraph::Neighbour toJ = { d, j };
+            TransitionGraph::keepNearest(nearest[i], toJ, maxNeighbours);
+        }
+    }
+}
+
+void SimilarityBuilder::beginBuild(){
+    nearest.assign(static_cast<size_t>(matrix.getNumLoops()), std::vector<TransitionGraph::Neighbour>());
+    for (auto& row : nearest)
+        row.reserve(static_cast<size_t>(maxNeighbours));
+}
+
+void SimilarityBuilder::build(TransitionGraph& graph, const OverlapLists& candidates, int numThreads){
+    jassert(candidates.getNumLoops() == matrix.getNumLoops());
+    beginBuild();
+    pairDistances.assign(static_cast<size_t>(candidates.getNumEntries()), 0.0f);
+
+    numThreads = jlimit(1, jmax(1, numBlocks), numThreads);
+    ThreadPool pool(numThreads);
+
+    //every pair has to be measured before a row may read its lower pairs
+    const SimilarityRowJob::Pass passes[] = { SimilarityRowJob::measure, SimilarityRowJob::select };
+    for (auto pass : passes){
+        OwnedArray<SimilarityRowJob> jobs;
+        Atomic<int> nextBlock;
+        for (int t = 0; t < numThreads; ++t)
+            pool.addJob(jobs.add(new SimilarityRowJob(*this, candidates, pass, nextBlock)), false);
+        for (auto* job : jobs)
+            pool.waitForJobToFinish(job, -1);
+    }
+
+    graph.assign(nearest, maxNeighbours);
+    nearest.clear();
+    pairDistances.clear();
+}
+
+void SimilarityBuilder::build(TransitionGraph& graph, const CandidateFunction& candidates, int numThreads){
+    isCandidate = candidates;
+    beginBuild();
+
+    std::vector<std::vector<Tile> > rounds;
+    scheduleRounds(numBlocks, rounds);
+
+    numThreads = jlimit(1, jmax(1, numBlocks), numThreads);
+    ThreadPool pool(numThreads);
+    OwnedArray<SimilarityTileJob> jobs;
+    for (int t = 0; t < numThreads; ++t)
+        jobs.add(new SimilarityTileJob(*this, tileSize));
+
+    //a round has to finish before the next one may touch the same rows
+    for (auto& round : rounds){
+        Atomic<int> nextTile;
+        for (auto* job : jobs){
+            job->setRound(round, nextTile);
+            pool.addJob(job, false);
+        }
+        for (auto* job : jobs)
+            pool.waitForJobToFinish(job, -1);
+    }
+
+    graph.assign(nearest, maxNeighbours);
+    nearest.clear();
+}
+
+}
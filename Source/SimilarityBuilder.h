@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    SimilarityBuilder.h
+    Created: 17 Oct 2026 10:31:16pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef SIMILARITYBUILDER_H_INCLUDED
+#define SIMILARITYBUILDER_H_INCLUDED
+
+#include <functional>
+#include "JuceHeader.h"
+#include "FeatureMatrix.h"
+#include "TransitionGraph.h"
+#include "OverlapLists.h"
+
+namespace mkov{
+
+/*
+    Builds a TransitionGraph from the upper triangle of the all-pairs distance
+    matrix without ever storing that matrix. The triangle is cut into square
+    tiles of tileSize loops, small enough that a tile's feature columns stay in
+    cache. Each tile is computed exactly once and read both ways: distance(i,j)
+    updates row i's nearest neighbours and row j's, so symmetry costs nothing.
+    Tiles run on a thread pool in rounds of a round-robin tournament. No two
+    tiles in a round share a block of rows, so the per-row neighbour heaps need
+    no locking.
+    Given sparse candidate lists instead (the loops overlapping each loop),
+    the pairs are measured once each, into one distance per pair stored
+    alongside the lists: a block of tileSize rows measures each row against
+    its candidates above the diagonal with FeatureMatrix::distancesTo(). A
+    second pass then picks each row's nearest, reading the pairs below the
+    diagonal through the lists' mirrors. Both passes only write their own
+    rows' entries, so blocks go to the pool without rounds or locking.
+*/
+class SimilarityBuilder {
+public:
+    typedef std::function<bool (int, int)> CandidateFunction;
+
+    SimilarityBuilder(const FeatureMatrix& matrix, int maxNeighbours, int tileSize = 256);
+    ~SimilarityBuilder();
+
+    /** isCandidate must be symmetric; an empty function allows every pair. */
+    void build(TransitionGraph& graph, const CandidateFunction& isCandidate = CandidateFunction(),
+               int numThreads = SystemStats::getNumCpus());
+    /** Only the pairs in candidates are measured; the lists must be symmetric. */
+    void build(TransitionGraph& graph, const OverlapLists& candidates,
+               int numThreads = SystemStats::getNumCpus());
+
+private:
+    friend class SimilarityTileJob;
+    friend class SimilarityRowJob;
+
+    struct Tile { int rowBlock, colBlock; };
+
+    const FeatureMatrix& matrix;
+    const int maxNeighbours, tileSize, numBlocks;
+    CandidateFunction isCandidate;
+    std::vector<std::vector<TransitionGraph::Neighbour> > nearest;
+    std::vector<float> pairDistances;     //per OverlapLists entry, valid above the diagonal
+
+    static void scheduleRounds(int numBlocks, std::vector<std::vector<Tile> >& rounds);
+    void computeTile(const Tile& tile, float* scratch);
+    void measureRows(const OverlapLists& candidates, int rowBlock);
+    void selectRows(const OverlapLists& candidates, int rowBlock);
+    void beginBuild();
+
+    SimilarityBuilder(const SimilarityBuilder&);
+    SimilarityBuilder& operator=(const SimilarityBuilder&);
+};
+
+}
+
+#endif  // SIMILARITYBUILDER_H_INCLUDED
@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    SplicePlanner.cpp
+    Created: 18 Oct 2026 7:34:16pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "SplicePlanner.h"
+#include "LoopSamplerSource.h"
+
+//every this many dB of boundary mismatch doubles the crossfade
+static const float decibelsPerFadeStep = 6.0f;
+//the fade used for jumps the graph never planned
+static const int defaultFadeIndex = 2;
+
+SplicePlanner::SplicePlanner(const lgen::AudioAsset::Ptr& _asset, const std::vector<Loop>& loops,
+                             const mkov::TransitionGraph& _graph, const BoundaryCache& _boundaries) :
+    Thread("Splice planner"), asset(_asset), graph(_graph), boundaries(_boundaries)
+{
+    nominalStarts.reserve(loops.size());
+    nominalEnds.reserve(loops.size());
+    for (auto& loop : loops){
+        nominalStarts.push_back(roundToInt(loop.start * asset->getSampleRate()));
+        nominalEnds.push_back(roundToInt(loop.end * asset->getSampleRate()));
+    }
+    startThread(3);
+}
+
+SplicePlanner::~SplicePlanner(){
+    stopThread(2000);
+}
+
+SplicePlanner::Splice SplicePlanner::getSplice(int from, int to) const noexcept {
+    if (!isReady()){
+        const Splice hardCut = { nominalStarts[to], 0 };
+        return hardCut;
+    }
+
+    //rows are sorted by column, so the edge is a binary search of k entries away
+    const int* columns = graph.getColumns();
+    const int* edge = std::lower_bound(columns + graph.getRowBegin(from), columns + graph.getRowEnd(from), to);
+    if (edge != columns + graph.getRowEnd(from) && *edge == to){
+        const int e = static_cast<int>(edge - columns);
+        const Splice planned = { edgeEntries[e], edgeFades[e] };
+        return planned;
+    }
+
+    const Splice unplanned = { exitRising[from] ? risingEntries[to] : fallingEntries[to], defaultFadeIndex };
+    return unplanned;
+}
+
+void SplicePlanner::findCuts(int nominal, AudioSampleBuffer& window, int& nearest, bool& nearestRising,
+                             int& rising, int& falling) const {
+    const int first = jmax(0, nominal - (int) searchWindow);
+    const int last  = jmin(asset->getNumSamples(), nominal + (int) searchWindow + 1);
+    const int num   = last - first;
+
+    nearest = rising = falling = jlimit(0, jmax(0, asset->getNumSamples() - 1), nominal);
+    nearestRising = true;
+    if (num < 2) return;
+
+    //the cut has to be clean in every channel, so look at their sum
+    asset->read(window.getArrayOfWritePointers(), window.getNumChannels(), 0, first, num);
+    float* mix = window.getWritePointer(0);
+    for (int c = 1; c < window.getNumChannels(); ++c)
+        FloatVectorOperations::add(mix, window.getReadPointer(c), num);
+
+    int bestRising = -1, bestFalling = -1;
+    for (int n = 1; n < num; ++n){
+        const bool up   = mix[n - 1] <  0.0f && mix[n] >= 0.0f;
+        const bool down = mix[n - 1] >= 0.0f && mix[n] <  0.0f;
+        const int distance = std::abs(first + n - nominal);
+        if (up   && (bestRising  < 0 || distance < std::abs(first + bestRising  - nominal))) bestRising  = n;
+        if (down && (bestFalling < 0 || distance < std::abs(first + bestFalling - nominal))) bestFalling = n;
+    }
+
+    //no crossing of a slope in the window: take the quietest stretch instead
+    int quietest = 0;
+    if (bestRising < 0 || bestFalling < 0){
+        float energy = 0.0f, lowest = std::numeric_limits<float>::max();
+        for (int n = 0; n < num; ++n){
+            energy += mix[n] * mix[n];
+            if (n >= energyWindow)
+                energy -= mix[n - energyWindow] * mix[n - energyWindow];
+            if (n >= energyWindow - 1 && energy < lowest){
+                lowest = energy;
+                quietest = n - energyWindow / 2;
+            }
+        }
+    }
+    rising  = first + (bestRising  >= 0 ? bestRising  : quietest);
+    falling = first + (bestFalling >= 0 ? bestFalling : quietest);
+
+    nearestRising = std::abs(rising - nominal) <= std::abs(falling - nominal);
+    nearest = nearestRising ? rising : falling;
+}
+
+void SplicePlanner::run(){
+    const int numLoops = static_cast<int>(nominalStarts.size());
+    exits.resize(numLoops);
+    exitRising.resize(numLoops);
+    risingEntries.resize(numLoops);
+    fallingEntries.resize(numLoops);
+
+    AudioSampleBuffer window(asset->getNumChannels(), 2 * searchWindow + 1);
+    int ignored;
+    bool rising;
+    for (int i = 0; i < numLoops && !threadShouldExit(); ++i){
+        findCuts(nominalEnds[i], window, exits[i], rising, ignored, ignored);
+        exitRising[i] = rising ? 1 : 0;
+        findCuts(nominalStarts[i], window, ignored, rising, risingEntries[i], fallingEntries[i]);
+    }
+
+    edgeEntries.resize(graph.getNumEdges());
+    edgeFades.resize(graph.getNumEdges());
+    for (int i = 0; i < numLoops && !threadShouldExit(); ++i){
+        for (int e = graph.getRowBegin(i); e < graph.getRowEnd(i); ++e){
+            const int j = graph.getColumns()[e];
+            edgeEntries[e] = exitRising[i] ? risingEntries[j] : fallingEntries[j];
+            const int step = static_cast<int>(boundaries.spliceCost(i, j) / decibelsPerFadeStep);
+            edgeFades[e] = static_cast<unsigned char>(jlimit(1, (int) LoopSamplerSource::numFadeLengths, 1 + step));
+        }
+    }
+
+    if (!threadShouldExit()){
+        ready.set(1);
+        Logger::writeToLog("Splice plans ready: " + String(numLoops) + " loops, "
+                           + String(graph.getNumEdges()) + " edges");
+    }
+}
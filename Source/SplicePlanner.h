@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    SplicePlanner.h
+    Created: 18 Oct 2026 7:34:16pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef SPLICEPLANNER_H_INCLUDED
+#define SPLICEPLANNER_H_INCLUDED
+
+#include <vector>
+#include "JuceHeader.h"
+#include "AudioAsset.h"
+#include "BoundaryCache.h"
+#include "TransitionGraph.h"
+
+/*
+    Where, exactly, to cut for every transition the graph allows, worked out
+    on a background thread so the audio thread only looks it up. Each loop
+    leaves at the zero crossing nearest its nominal end (its exit). For each
+    edge i -> j the entry into j is the nearest zero crossing with the same
+    slope as i's exit, so the waveform carries on in the same direction; with
+    no such crossing within searchWindow it is the quietest point there. The
+    equal-power crossfade grows with the edge's boundary mismatch: louder or
+    brighter jumps get longer fades (LoopSamplerSource fade indices).
+    Until isReady() every splice is a hard cut at the nominal loop points.
+*/
+class SplicePlanner : private Thread {
+public:
+    enum { searchWindow = 512, energyWindow = 32 };
+
+    struct Splice {
+        int entry;          //first sample of the new loop, in asset samples
+        int fadeIndex;      //see LoopSamplerSource::getFadeLength()
+    };
+
+    /** Starts planning straight away. graph and boundaries must outlive it. */
+    SplicePlanner(const lgen::AudioAsset::Ptr& asset, const std::vector<Loop>& loops,
+                  const mkov::TransitionGraph& graph, const BoundaryCache& boundaries);
+    ~SplicePlanner();
+
+    bool isReady() const noexcept { return ready.get() != 0; }
+
+    /** The sample after a loop's last one. */
+    int getExit(int loop) const noexcept { return isReady() ? exits[loop] : nominalEnds[loop]; }
+    Splice getSplice(int from, int to) const noexcept;
+
+private:
+    const lgen::AudioAsset::Ptr asset;
+    const mkov::TransitionGraph& graph;
+    const BoundaryCache& boundaries;
+    std::vector<int> nominalStarts, nominalEnds;
+    Atomic<int> ready;
+
+    //filled by run(), read only once ready
+    std::vector<int> exits;
+    std::vector<char> exitRising;
+    std::vector<int> risingEntries, fallingEntries;   //per loop, nearest crossing of each slope
+    std::vector<int> edgeEntries;
+    std::vector<unsigned char> edgeFades;
+
+    void run() override;
+    void findCuts(int nominal, AudioSampleBuffer& window, int& nearest, bool& nearestRising,
+                  int& rising, int& falling) const;
+
+    SplicePlanner(const SplicePlanner&);
+    SplicePlanner& operator=(const SplicePlanner&);
+};
+
+
+#endif  // SPLICEPLANNER_H_INCLUDED
@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    TransitionGraph.cpp
+    Created: 17 Oct 2026 9:05:37pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "TransitionGraph.h"
+
+namespace mkov{
+
+TransitionGraph::TransitionGraph() : rowOffsets(1, 0)
+{
+}
+
+TransitionGraph::~TransitionGraph(){}
+
+void TransitionGraph::clear(int numStates, int maxNeighbours){
+    rowOffsets.clear();
+    columns.clear();
+    weights.clear();
+    similarities.clear();
+
+    rowOffsets.reserve(static_cast<size_t>(numStates) + 1);
+    columns.reserve(static_cast<size_t>(numStates) * maxNeighbours);
+    weights.reserve(static_cast<size_t>(numStates) * maxNeighbours);
+    similarities.reserve(static_cast<size_t>(numStates) * maxNeighbours);
+    rowOffsets.push_back(0);
+    removed.assign(static_cast<size_t>(numStates), Atomic<int>());
+}
+
+void TransitionGraph::assign(std::vector<std::vector<Neighbour> >& rows, int maxNeighbours){
+    clear(static_cast<int>(rows.size()), maxNeighbours);
+    for (auto& row : rows)
+        appendRow(row);
+    buildReverseEdges();
+}
+
+void TransitionGraph::buildReverseEdges(){
+    const int numStates = getNumStates();
+    inOffsets.assign(static_cast<size_t>(numStates) + 1, 0);
+    for (int c : columns)
+        ++inOffsets[c + 1];
+    for (int i = 0; i < numStates; ++i)
+        inOffsets[i + 1] += inOffsets[i];
+
+    inRows.resize(columns.size());
+    std::vector<int> fill(inOffsets.begin(), inOffsets.end() - 1);
+    for (int i = 0; i < numStates; ++i)
+        for (int e = getRowBegin(i); e < getRowEnd(i); ++e)
+            inRows[fill[columns[e]]++] = i;
+}
+
+void TransitionGraph::keepNearest(std::vector<Neighbour>& nearest, const Neighbour& n, int maxNeighbours){
+    if (static_cast<int>(nearest.size()) < maxNeighbours){
+        nearest.push_back(n);
+        std::push_heap(nearest.begin(), nearest.end());
+    } else if (maxNeighbours > 0 && n < nearest.front()){
+        std::pop_heap(nearest.begin(), nearest.end());
+        nearest.back() = n;
+        std::push_heap(nearest.begin(), nearest.end());
+    }
+}
+
+void TransitionGraph::blendEdgeCosts(const std::function<float (int, int)>& cost, float amount){
+    std::vector<float> costs(columns.size());
+    double distanceSum = 0.0, costSum = 0.0;
+    for (int i = 0; i < getNumStates(); ++i){
+        for (int e = getRowBegin(i); e < getRowEnd(i); ++e){
+            costs[e] = cost(i, columns[e]);
+            distanceSum += 1.0 / similarities[e] - 1.0;
+            costSum += costs[e];
+        }
+    }
+    if (costSum <= 0.0) return;
+
+    const float scale = static_cast<float>(distanceSum / costSum);
+    for (int i = 0; i < getNumStates(); ++i){
+        for (int e = getRowBegin(i); e < getRowEnd(i); ++e){
+            const float distance = 1.0f / similarities[e] - 1.0f;
+            similarities[e] = 1.0f / (1.0f + (1.0f - amount) * distance + amount * scale * costs[e]);
+        }
+        normaliseRow(i);
+    }
+}
+
+void TransitionGraph::appendRow(std::vector<Neighbour>& nearest){
+    //columns in ascending order keep the row walk cache friendly
+    std::sort(nearest.begin(), nearest.end(),
+              [](const Neighbour& a, const Neighbour& b){ return a.state < b.state; });
+
+    for (auto& n : nearest){
+        columns.push_back(n.state);
+        similarities.push_back(1.0f / (1.0f + n.distance));
+    }
+    weights.resize(similarities.size());
+
+    rowOffsets.push_back(static_cast<int>(columns.size()));
+    normaliseRow(getNumStates() - 1);
+}
+
+void TransitionGraph::normaliseRow(int state){
+    //weights are the similarities of the live successors, scaled to sum to one
+    const int begin = getRowBegin(state), end = getRowEnd(state);
+    double rowSum = 0.0;
+    for (int e = begin; e < end; ++e){
+        weights[e] = isRemoved(columns[e]) ? 0.0f : similarities[e];
+        rowSum += weights[e];
+    }
+    if (rowSum > 0.0)
+        FloatVectorOperations::multiply(weights.data() + begin, static_cast<float>(1.0 / rowSum), end - begin);
+}
+
+void TransitionGraph::setRemoved(int state, bool isRemoved, Array<int>& changedRows){
+    removed[state] = isRemoved ? 1 : 0;
+    for (int r = inOffsets[state]; r < inOffsets[state + 1]; ++r){
+        normaliseRow(inRows[r]);
+        changedRows.addIfNotAlreadyThere(inRows[r]);
+    }
+}
+
+void TransitionGraph::removeState(int state, Array<int>& changedRows){
+    setRemoved(state, true, changedRows);
+}
+
+void TransitionGraph::restoreState(int state, Array<int>& changedRows){
+    setRemoved(state, false, changedRows);
+}
+
+size_t TransitionGraph::getMemoryBytes() const noexcept {
+    return (rowOffsets.capacity() + columns.capacity() + inOffsets.capacity() + inRows.capacity()) * sizeof(int)
+         + (weights.capacity() + similarities.capacity()) * sizeof(float)
+         + removed.capacity() * sizeof(Atomic<int>);
+}
+
+}
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    TransitionGraph.h
+    Created: 17 Oct 2026 9:05:37pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef TRANSITIONGRAPH_H_INCLUDED
+#define TRANSITIONGRAPH_H_INCLUDED
+
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include "JuceHeader.h"
+
+namespace mkov{
+
+/*
+    Sparse Markov transition graph in CSR form: row i's successors are
+    columns[rowOffsets[i] .. rowOffsets[i+1]) with the matching float
+    probabilities in weights, which sum to one per row. Each row keeps only
+    its k most similar candidates, so memory is O(N*k) rather than the N*N
+    doubles of a dense MATRIX. A row with no candidates is left empty.
+    States can be removed and restored in place: a reverse adjacency list finds
+    the rows that lead to a state, and only those are renormalised. Removed
+    states keep their index and their edges, at zero weight.
+*/
+class TransitionGraph {
+public:
+    struct Neighbour {
+        float distance;
+        int   state;
+        bool operator<(const Neighbour& other) const noexcept { return distance < other.distance; }
+    };
+
+    TransitionGraph();
+    ~TransitionGraph();
+
+    /** Builds the graph from rows already reduced to their nearest neighbours
+        (see keepNearest); the dense matrix never exists. Similarity, and so
+        the transition weight, is 1 / (1 + distance). The rows are sorted in
+        place. */
+    void assign(std::vector<std::vector<Neighbour> >& rows, int maxNeighbours);
+
+    /** Adds n to a row of at most maxNeighbours nearest, kept as a max-heap on
+        distance so the worst neighbour so far is at the front. */
+    static void keepNearest(std::vector<Neighbour>& nearest, const Neighbour& n, int maxNeighbours);
+
+    /** Mixes cost(from, to) into every kept edge: its distance becomes
+        (1 - amount) * distance + amount * cost, with the costs first scaled to
+        the same mean as the distances. Only the k edges already chosen are
+        visited. Call once, after assign(). */
+    void blendEdgeCosts(const std::function<float (int, int)>& cost, float amount);
+
+    int getNumStates() const noexcept { return static_cast<int>(rowOffsets.size()) - 1; }
+    int getNumEdges()  const noexcept { return static_cast<int>(columns.size()); }
+
+    int getRowBegin(int state) const noexcept { return rowOffsets[state]; }
+    int getRowEnd(int state)   const noexcept { return rowOffsets[state + 1]; }
+    int getDegree(int state)   const noexcept { return getRowEnd(state) - getRowBegin(state); }
+
+    const int*   getColumns() const noexcept { return columns.data(); }
+    const float* getWeights() const noexcept { return weights.data(); }
+
+    size_t getMemoryBytes() const noexcept;
+
+    /** Drops every transition into state and renormalises the rows that had
+        one, which are added to changedRows. O(in-degree * k). */
+    void removeState(int state, Array<int>& changedRows);
+    void restoreState(int state, Array<int>& changedRows);
+
+    /** Lock free, so the player can skip loops removed after they were queued. */
+    bool isRemoved(int state) const noexcept { return removed[state].get() != 0; }
+
+private:
+    std::vector<int>   rowOffsets;
+    std::vector<int>   columns;
+    std::vector<float> weights;
+    std::vector<float> similarities;    //un-normalised 1 / (1 + distance) per edge
+
+    //rows with an edge into each state, CSR style
+    std::vector<int>   inOffsets, inRows;
+    std::vector<Atomic<int> > removed;
+
+    void clear(int numStates, int maxNeighbours);
+    void appendRow(std::vector<Neighbour>& nearest);
+    void buildReverseEdges();
+    void normaliseRow(int state);
+    void setRemoved(int state, bool isRemoved, Array<int>& changedRows);
+
+    TransitionGraph(const TransitionGraph&);
+    TransitionGraph& operator=(const TransitionGraph&);
+};
+
+}
+
+#endif  // TRANSITIONGRAPH_H_INCLUDED
@@ -0,0 +1,159 @@
+/*
+  ==============================================================================
+
+    VariableOrderModel.cpp
+    Created: 18 Oct 2026 2:41:07pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#include "VariableOrderModel.h"
+#include "MarkovWalker.h"
+
+namespace mkov{
+
+//past this load factor new contexts are dropped rather than slowing every probe
+static const double maxLoad = 0.75;
+
+VariableOrderModel::VariableOrderModel(int order, size_t memoryCapBytes) :
+    maxOrder(jlimit(1, (int) maxSupportedOrder, order)),
+    numContexts(0), numDropped(0)
+{
+    //a power of two, so probing can mask instead of divide
+    size_t capacity = 1;
+    while (capacity * 2 * sizeof(Context) <= memoryCapBytes)
+        capacity *= 2;
+
+    Context empty;
+    zerostruct(empty);
+    entries.assign(capacity, empty);
+}
+
+VariableOrderModel::~VariableOrderModel(){}
+
+uint64 VariableOrderModel::hashContext(const int* history, int order) noexcept {
+    //FNV-1a over the order and the loop indices; 0 is reserved for empty entries
+    uint64 h = 14695981039346656037ULL ^ static_cast<uint64>(order);
+    for (int n = 0; n < order; ++n){
+        h ^= static_cast<uint32>(history[n]);
+        h *= 1099511628211ULL;
+    }
+    return h == 0 ? 1 : h;
+}
+
+const VariableOrderModel::Context* VariableOrderModel::find(uint64 key) const noexcept {
+    const size_t mask = entries.size() - 1;
+    for (size_t i = static_cast<size_t>(key) & mask;; i = (i + 1) & mask){
+        if (entries[i].key == key) return &entries[i];
+        if (entries[i].key == 0)   return nullptr;
+    }
+}
+
+VariableOrderModel::Context* VariableOrderModel::findOrInsert(uint64 key) noexcept {
+    const size_t mask = entries.size() - 1;
+    for (size_t i = static_cast<size_t>(key) & mask;; i = (i + 1) & mask){
+        if (entries[i].key == key)
+            return &entries[i];
+        if (entries[i].key == 0){
+            if (numContexts + 1 > maxLoad * entries.size()){
+                ++numDropped;
+                return nullptr;
+            }
+            ++numContexts;
+            entries[i].key = key;
+            return &entries[i];
+        }
+    }
+}
+
+void VariableOrderModel::observe(const int* history, int historyLength, int next){
+    for (int order = 2; order <= jmin(maxOrder, historyLength); ++order)
+        observeOrder(history, order, next);
+}
+
+void VariableOrderModel::observeOrder(const int* history, int order, int next){
+    jassert(order >= 2 && order <= maxOrder);
+    Context* c = findOrInsert(hashContext(history, order));
+    if (c == nullptr) return;
+
+    int slot = 0;
+    for (int s = 0; s < slotsPerContext; ++s){
+        if (c->count[s] > 0 && c->next[s] == next){ slot = s; break; }
+        if (c->count[s] < c->count[slot]) slot = s;
+    }
+    if (c->count[slot] == 0 || c->next[slot] != next){
+        //space-saving: the newcomer inherits the evicted count
+        c->next[slot] = next;
+    }
+    if (c->count[slot] == 0xffff)
+        for (auto& n : c->count) n >>= 1;
+    ++c->count[slot];
+}
+
+int VariableOrderModel::sample(const int* history, int historyLength, float r, float exponent) const noexcept {
+    for (int order = jmin(maxOrder, historyLength); order >= 2; --order){
+        const Context* c = find(hashContext(history, order));
+        if (c == nullptr) continue;
+
+        float weight[slotsPerContext];
+        float total = 0.0f;
+        for (int s = 0; s < slotsPerContext; ++s){
+            weight[s] = c->count[s] == 0 ? 0.0f
+                      : exponent == 1.0f ? (float) c->count[s] : std::pow((float) c->count[s], exponent);
+            total += weight[s];
+        }
+        if (total == 0.0f) continue;
+
+        float pick = r * total;
+        int last = 0;
+        for (int s = 0; s < slotsPerContext; ++s){
+            if (weight[s] == 0.0f) continue;
+            pick -= weight[s];
+            if (pick < 0.0f)
+                return c->next[s];
+            last = s;
+        }
+        //rounding left a sliver past the end
+        return c->next[last];
+    }
+    return -1;
+}
+
+//==========================Benchmark===========================================
+void VariableOrderModel::benchmark(AliasTable& table, int numSteps){
+    if (table.getGraph().getNumStates() == 0) return;
+    const ScopedLock sl(table.getLock());
+
+    for (int order = 1; order <= maxSupportedOrder; ++order){
+        VariableOrderModel model(order);
+        MarkovWalker walker(table, 0, 1);
+        Random random(1);
+        int history[maxSupportedOrder] = { 0 };
+        int historyLength = 1;
+
+        const double start = Time::getMillisecondCounterHiRes();
+        for (int n = 0; n < numSteps; ++n){
+            int next = model.sample(history, historyLength, random.nextFloat());
+            if (next < 0 || random.nextBool())
+                next = walker.step();
+            else
+                walker.setState(next);
+
+            model.observe(history, historyLength, next);
+            for (int h = maxSupportedOrder - 1; h > 0; --h)
+                history[h] = history[h - 1];
+            history[0] = next;
+            historyLength = jmin(historyLength + 1, (int) maxSupportedOrder);
+        }
+        const double secs = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+        Logger::writeToLog("VariableOrderModel benchmark (order " + String(order) + "): "
+                           + String(numSteps / secs / 1.0e6, 2) + " M steps/s, "
+                           + String(model.getNumContexts()) + " contexts ("
+                           + String(model.getNumDropped()) + " dropped), "
+                           + String((int) (model.getMemoryBytes() / 1024)) + " KB");
+    }
+}
+
+}
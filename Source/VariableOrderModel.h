@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    VariableOrderModel.h
+    Created: 18 Oct 2026 2:41:07pm
+    Author:  milrob
+
+  ==============================================================================
+*/
+
+#ifndef VARIABLEORDERMODEL_H_INCLUDED
+#define VARIABLEORDERMODEL_H_INCLUDED
+
+#include <vector>
+#include "JuceHeader.h"
+#include "AliasTable.h"
+
+namespace mkov{
+
+/*
+    Second and higher order transitions learnt from loop sequences, on top of
+    the first-order similarity graph. A context is the last n loops played
+    (n = 2 .. maxOrder); it is hashed to 64 bits and stored in a fixed-size
+    open-addressed table, so memory never grows past the cap given to the
+    constructor. Each context remembers at most slotsPerContext successors;
+    a new one replaces the least seen (the space-saving scheme), so frequent
+    continuations survive. sample() tries the longest context first and falls
+    back to shorter ones; with nothing seen it returns -1 and the caller uses
+    the first-order graph.
+*/
+class VariableOrderModel {
+public:
+    enum { maxSupportedOrder = 3, slotsPerContext = 4 };
+
+    VariableOrderModel(int maxOrder, size_t memoryCapBytes = 4 * 1024 * 1024);
+    ~VariableOrderModel();
+
+    int getMaxOrder() const noexcept { return maxOrder; }
+
+    /** history[0] is the most recent loop. Counts next against every context
+        order the history is long enough for. */
+    void observe(const int* history, int historyLength, int next);
+    /** Counts next against the context of exactly the first order loops of history. */
+    void observeOrder(const int* history, int order, int next);
+
+    /** A successor for the longest known context, picked in proportion to how
+        often it followed raised to exponent (1 / temperature, as in
+        AliasTable), or -1. r is uniform in [0, 1). */
+    int sample(const int* history, int historyLength, float r, float exponent = 1.0f) const noexcept;
+
+    int    getNumContexts() const noexcept { return numContexts; }
+    int    getNumDropped()  const noexcept { return numDropped; }
+    size_t getMemoryBytes() const noexcept { return entries.size() * sizeof(Context); }
+
+    /** Logs steps/s and memory for orders 1 to maxSupportedOrder walking table. */
+    static void benchmark(AliasTable& table, int numSteps = 1000000);
+
+private:
+    struct Context {
+        uint64 key;                     //0 marks an empty entry
+        int    next[slotsPerContext];
+        uint16 count[slotsPerContext];
+    };
+
+    const int maxOrder;
+    std::vector<Context> entries;
+    int numContexts, numDropped;
+
+    static uint64 hashContext(const int* history, int order) noexcept;
+    const Context* find(uint64 key) const noexcept;
+    Context* findOrInsert(uint64 key) noexcept;
+
+    VariableOrderModel(const VariableOrderModel&);
+    VariableOrderModel& operator=(const VariableOrderModel&);
+};
+
+}
+
+#endif  // VARIABLEORDERMODEL_H_INCLUDED